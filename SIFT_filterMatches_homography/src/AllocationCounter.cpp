@@ -0,0 +1,94 @@
+//
+//  AllocationCounter.cpp
+//  SIFT_filterMatches_homography
+//
+
+#include "AllocationCounter.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+
+#ifdef COUNT_ALLOCATIONS
+
+static std::atomic<uint64_t> allocCount(0);
+static std::atomic<uint64_t> allocBytes(0);
+
+uint64_t AllocationCounter::getCount(){
+    return allocCount.load(std::memory_order_relaxed);
+}
+
+uint64_t AllocationCounter::getBytes(){
+    return allocBytes.load(std::memory_order_relaxed);
+}
+
+bool AllocationCounter::isEnabled(){
+    return true;
+}
+
+
+//--------------------------------------------------------------
+// replacement global operator new / delete
+// every form has to be replaced together, since they all go through malloc / free now
+//--------------------------------------------------------------
+
+static void* countedAlloc(size_t size){
+
+    allocCount.fetch_add(1, std::memory_order_relaxed);
+    allocBytes.fetch_add(size, std::memory_order_relaxed);
+
+    return malloc(size > 0 ? size : 1);
+}
+
+void* operator new(size_t size){
+    void* p = countedAlloc(size);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void* operator new[](size_t size){
+    void* p = countedAlloc(size);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept{
+    return countedAlloc(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept{
+    return countedAlloc(size);
+}
+
+void operator delete(void* p) noexcept{
+    free(p);
+}
+
+void operator delete[](void* p) noexcept{
+    free(p);
+}
+
+void operator delete(void* p, const std::nothrow_t&) noexcept{
+    free(p);
+}
+
+void operator delete[](void* p, const std::nothrow_t&) noexcept{
+    free(p);
+}
+
+#else
+
+uint64_t AllocationCounter::getCount(){
+    return 0;
+}
+
+uint64_t AllocationCounter::getBytes(){
+    return 0;
+}
+
+bool AllocationCounter::isEnabled(){
+    return false;
+}
+
+#endif
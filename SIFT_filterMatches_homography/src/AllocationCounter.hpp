@@ -0,0 +1,31 @@
+//
+//  AllocationCounter.hpp
+//  SIFT_filterMatches_homography
+//
+
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+
+// counts calls to the global operator new / new[] (replaced in AllocationCounter.cpp)
+// for checking that a code path does no heap allocations once warmed up:
+//
+//     uint64_t before = AllocationCounter::getCount();
+//     matcher.matchDescriptors();
+//     uint64_t allocs = AllocationCounter::getCount() - before;
+//
+// covers std containers, strings, streams and anything made with new.
+// cv::Mat data comes from cv::fastMalloc (plain malloc), so it isn't counted here
+//
+// only built with COUNT_ALLOCATIONS defined (-DCOUNT_ALLOCATIONS in config.make's PROJECT_CFLAGS,
+// or COUNT_ALLOCATIONS=1 in the Xcode project's preprocessor macros). without it the app keeps
+// the standard operator new and the counts stay at 0
+
+namespace AllocationCounter {
+
+    uint64_t getCount(); // allocations since the program started
+    uint64_t getBytes(); // bytes requested by them
+    bool isEnabled(); // built with COUNT_ALLOCATIONS
+
+}
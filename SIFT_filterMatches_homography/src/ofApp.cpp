@@ -1,5 +1,7 @@
 #include "ofApp.h"
 
+#include <cassert>
+
 //--------------------------------------------------------------
 void ofApp::setup(){
     
@@ -21,20 +23,42 @@ void ofApp::setup(){
     
     siftMatcher.filterMatches(); // filter matches
     
-    siftMatcher.drawMatchesCv(matchImg, true); // draw good matches into matchImg
-    
     siftMatcher.getHomography(true); // calculate homography between (good) matched keypoints
                                  // and calc corresponding transformation on findImg
     
+    siftMatcher.refineHomography(); // guided matching around the homography's prediction, then fit again
+    
     
     // load the pre-warped cropped image for reference in ofApp::draw()
     refImg.load("peeping_tom_crop2.jpg");
     
+    // tracker for the 't' tracking demo
+    tracker.setup(findImg);
+    
 }
 
 //--------------------------------------------------------------
 void ofApp::update(){
     
+    if (bTracking){
+        
+        // simulate a handheld camera over fieldImg: slow drift, rotation and zoom
+        
+        float t = ofGetElapsedTimef();
+        Mat fieldMat = toCv(fieldImg);
+        
+        Point2f center(fieldMat.cols * 0.5, fieldMat.rows * 0.5);
+        Mat M = getRotationMatrix2D(center, 3 * sin(t * 0.5), 1 + 0.1 * sin(t * 0.3));
+        M.at<double>(0,2) += 40 * sin(t * 0.7);
+        M.at<double>(1,2) += 20 * cos(t * 0.9);
+        
+        warpAffine(fieldMat, trackMat, M, fieldMat.size());
+        
+        toOf(trackMat, trackImg); // allocates once, then copies
+        trackImg.update();
+        
+        tracker.update(trackImg.getPixels());
+    }
 }
 
 //--------------------------------------------------------------
@@ -42,8 +66,46 @@ void ofApp::draw(){
     
     ofBackground(0);
     
-    // draw matchImg
-    matchImg.draw(0,0);
+    if (bTracking){
+        
+        // draw simulated video + tracked findImg
+        
+        trackImg.draw(0,0);
+        tracker.draw();
+        
+        if (tracker.isKeyframe()){
+            
+            // show the part of the frame the keyframe's SIFT detection searched
+            
+            ofPushStyle();
+            ofNoFill();
+            ofSetColor(255,255,0);
+            ofDrawRectangle(tracker.matcher.getSearchRect());
+            ofPopStyle();
+        }
+        
+        string status = tracker.isKeyframe() ? "keyframe (SIFT match)" : "tracked (sparse flow)";
+        if (!tracker.isFound()) status = "lost";
+        
+        ofDrawBitmapStringHighlight(status + ", " + ofToString(tracker.getNumTracked()) + " points, "
+                                    + ofToString((int) ofGetFrameRate()) + "fps\n't' to stop tracking", 10, 20);
+        return;
+    }
+    
+    if (bMulti){
+        
+        fieldImg.draw(0,0);
+        multiMatcher.draw();
+        
+        ofDrawBitmapStringHighlight(ofToString(multiMatcher.getDetections().size()) + " of " + ofToString(multiMatcher.getNumQueries())
+                                    + " queries found\n'm' to go back", 10, 20);
+        return;
+    }
+    
+    // draw findImg + fieldImg side by side, with (good) matched keypoints connected
+    siftMatcher.drawMatchesMesh(0, 0, true);
+    // (siftMatcher.drawMatchesCv(matchImg, true) would rasterize the same into an ofImage with cv::drawMatches,
+    //  then upload the whole thing as a new texture)
     
     /*
     // sidenote on drawing Mats:
@@ -57,7 +119,7 @@ void ofApp::draw(){
     
     // draw box around findImg inside fieldImg
     siftMatcher.drawHomography(findImg.getWidth());
-        //offset by findImg width to correspond to matchImg
+        //offset by findImg width, where drawMatchesMesh() draws fieldImg
     
     
     // draw the original crop from the image, before I warped it in photoshop
@@ -71,6 +133,114 @@ void ofApp::draw(){
 //--------------------------------------------------------------
 void ofApp::keyPressed(int key){
     
+    if (key == 't'){
+        bTracking = !bTracking; // toggle tracking demo
+    }
+    
+    if (key == 'b'){
+        benchmarkBackends();
+    }
+    
+    if (key == 'c'){
+        testCompression();
+    }
+    
+    if (key == 'a'){
+        testAllocations();
+    }
+    
+    if (key == 'm'){
+        bMulti = !bMulti; // toggle multi-object demo
+        if (bMulti && multiMatcher.getNumQueries() == 0){
+            setupMultiDetection();
+        }
+        if (bMulti){
+            multiMatcher.detect(fieldImg);
+        }
+    }
+}
+
+//--------------------------------------------------------------
+void ofApp::benchmarkBackends(){
+    
+    // runs the full pipeline (match, filter, homography) with each feature backend
+    // on fresh copies of the test images, and compares against SIFT
+    
+    FeatureType types[] = { FEATURE_SIFT, FEATURE_ORB, FEATURE_BRISK };
+    
+    vector<ofVec2f> siftCorners;
+    stringstream results;
+    
+    results << "backend | ms | keypoints find/field | bytes per descriptor | good matches | inliers | reproj. error px | corner offset from SIFT px" << endl;
+    
+    for (int i=0; i<3; i++){
+        
+        ofImage find, field;
+        find.setUseTexture(false);
+        field.setUseTexture(false);
+        find.load("peeping_tom_crop2-3d.jpg");
+        field.load("peeping_tom_scene.jpg");
+        
+        SIFTMatcher matcher(find, field);
+        matcher.setFeatureBackend(types[i], 2000);
+        
+        uint64_t startTime = ofGetElapsedTimeMillis();
+        
+        matcher.match();
+        matcher.filterMatches();
+        bool bFound = matcher.getHomography(true);
+        
+        uint64_t totalTime = ofGetElapsedTimeMillis() - startTime;
+        
+        
+        // corner offset: mean distance of each corner from where SIFT put it
+        
+        float cornerOffset = 0;
+        
+        if (i == 0){
+            siftCorners = matcher.fieldCorners;
+        } else if (bFound && siftCorners.size() == 4){
+            for (int c=0; c<4; c++){
+                cornerOffset += matcher.fieldCorners[c].distance(siftCorners[c]) / 4;
+            }
+        }
+        
+        results << matcher.getFeatureBackend()->getName() << " | " << totalTime
+        << " | " << matcher.findKeypoints.size() << "/" << matcher.fieldKeypoints.size()
+        << " | " << matcher.getDescriptorBytes()
+        << " | " << matcher.goodMatches.size()
+        << " | " << matcher.getNumInliers()
+        << " | " << (bFound ? ofToString(matcher.getReprojectionError(), 2) : "failed")
+        << " | " << (i == 0 ? "-" : ofToString(cornerOffset, 1)) << endl;
+    }
+    
+    // there's no ground truth for the scene, so the corner offset is agreement with SIFT's result
+    // (itself not exact), not accuracy. reprojection error is each backend's own inliers against its own fit
+    
+    ofLogNotice("benchmarkBackends") << endl << results.str()
+    << "(corner offset is from SIFT's corners, not from ground truth)";
+}
+
+//--------------------------------------------------------------
+void ofApp::setupMultiDetection(){
+    
+    // the test images only have so many things to find:
+    // the warped crop (findImg), the original crop, and two more crops straight from fieldImg
+    
+    multiMatcher.setup(FEATURE_SIFT, 2000, 12);
+    
+    multiMatcher.addQuery(findImg, "crop (warped)");
+    multiMatcher.addQuery(refImg, "crop (original)");
+    
+    float w = fieldImg.getWidth(), h = fieldImg.getHeight();
+    ofImage crop;
+    crop.setUseTexture(false);
+    
+    crop.cropFrom(fieldImg, w * 0.05, h * 0.6, w * 0.25, h * 0.3);
+    multiMatcher.addQuery(crop, "bottom left");
+    
+    crop.cropFrom(fieldImg, w * 0.7, h * 0.05, w * 0.25, h * 0.3);
+    multiMatcher.addQuery(crop, "top right");
 }
 
 //--------------------------------------------------------------
@@ -122,3 +292,123 @@ void ofApp::gotMessage(ofMessage msg){
 void ofApp::dragEvent(ofDragInfo dragInfo){
     
 }
+
+//--------------------------------------------------------------
+void ofApp::testCompression(){
+    
+    // compress siftMatcher's fieldImg descriptors at 16 and 32 bytes,
+    // then measure how often the true nearest neighbor survives, and rerun the matcher with them.
+    // the compressors are trained on other images (the crop1 pair), so recall is measured on descriptors
+    // they haven't seen, like a codebook trained once and used on new footage
+    
+    if (siftMatcher.fieldDescriptors.rows < 10 || siftMatcher.getFeatureBackend()->isBinary()){
+        ofLogWarning("testCompression") << "needs SIFT descriptors in fieldImg (match with SIFT first)";
+        return;
+    }
+    
+    shared_ptr<FeatureBackend> sift = createFeatureBackend(FEATURE_SIFT, 2000);
+    Mat trainDescriptors;
+    
+    for (string path : {"peeping_tom_crop1.jpg", "peeping_tom_crop1-3d.jpg"}){
+        
+        ofImage img;
+        img.setUseTexture(false);
+        if (!img.load(path)) continue;
+        img.setImageType(OF_IMAGE_GRAYSCALE); // a local copy, fine to convert
+        
+        vector<KeyPoint> keypoints;
+        Mat descriptors;
+        sift->detectAndCompute(toCv(img.getPixels()), keypoints, descriptors);
+        trainDescriptors.push_back(descriptors);
+    }
+    
+    if (trainDescriptors.rows < 256){
+        ofLogWarning("testCompression") << "needs at least 256 SIFT descriptors to train on, the crop1 images have " << trainDescriptors.rows;
+        return;
+    }
+    
+    int codeSizes[] = { 16, 32 };
+    stringstream results;
+    
+    // recall vs raw SIFT's own nearest neighbors, and (in parentheses) vs RootSIFT's, i.e. without RootSIFT's own changes
+    
+    results << "bytes per descriptor | recall@1 | recall@10 | good matches | inliers (raw SIFT: "
+    << siftMatcher.goodMatches.size() << " good, " << siftMatcher.getNumInliers() << " inliers)" << endl;
+    
+    for (int i=0; i<2; i++){
+        
+        shared_ptr<DescriptorCompressor> compressor(new DescriptorCompressor());
+        compressor->setup(64, codeSizes[i]);
+        compressor->train(trainDescriptors); // not the evaluated fieldImg
+        
+        DescriptorCompressor::Recall recall = compressor->measureRecall(siftMatcher.findDescriptors, siftMatcher.fieldDescriptors);
+        
+        SIFTMatcher matcher(findImg, fieldImg);
+        matcher.setCompressor(compressor);
+        matcher.match();
+        matcher.filterMatches();
+        matcher.getHomography(true);
+        
+        results << compressor->getCodeBytes()
+        << " | " << ofToString(recall.at1, 3) << " (" << ofToString(recall.rootAt1, 3) << ")"
+        << " | " << ofToString(recall.at10, 3) << " (" << ofToString(recall.rootAt10, 3) << ")"
+        << " | " << matcher.goodMatches.size() << " | " << matcher.getNumInliers() << endl;
+    }
+    
+    ofLogNotice("testCompression") << endl << results.str();
+}
+
+//--------------------------------------------------------------
+void ofApp::testAllocations(){
+    
+    // repeated matching on the same images, as in a video loop:
+    // after a few warm-up rounds the buffers have grown to size,
+    // then every step is measured with the allocation counter.
+    // matchDescriptors, filterMatches and the point buffers should stay at 0,
+    // detection + findHomography allocate inside OpenCV (mostly through cv::fastMalloc, not counted)
+    
+    if (!AllocationCounter::isEnabled()){
+        ofLogWarning("testAllocations") << "build with COUNT_ALLOCATIONS defined to count allocations (see AllocationCounter.hpp)";
+        return;
+    }
+    
+    const int nWarmup = 3, nRuns = 10;
+    
+    SIFTMatcher matcher(findImg, fieldImg);
+    matcher.setFeatureBackend(FEATURE_SIFT, 2000);
+    matcher.setLogging(false);
+    
+    uint64_t allocs[4] = { 0, 0, 0, 0 };
+    
+    for (int i=0; i<nWarmup + nRuns; i++){
+        
+        uint64_t count = AllocationCounter::getCount();
+        matcher.match(); // detect + describe + match
+        uint64_t matchCount = AllocationCounter::getCount();
+        matcher.matchDescriptors(); // matching alone, again
+        uint64_t matchDescCount = AllocationCounter::getCount();
+        matcher.filterMatches();
+        uint64_t filterCount = AllocationCounter::getCount();
+        matcher.getHomography(true);
+        uint64_t homographyCount = AllocationCounter::getCount();
+        
+        if (i >= nWarmup){
+            allocs[0] += matchCount - count;
+            allocs[1] += matchDescCount - matchCount;
+            allocs[2] += filterCount - matchDescCount;
+            allocs[3] += homographyCount - filterCount;
+        }
+    }
+    
+    ofLogNotice("testAllocations") << "allocations per call after " << nWarmup << " warm-up rounds (avg of " << nRuns << ")" << endl
+    << "  match (detect + describe + match): " << allocs[0] / (float) nRuns << endl
+    << "  matchDescriptors: " << allocs[1] / (float) nRuns << endl
+    << "  filterMatches: " << allocs[2] / (float) nRuns << endl
+    << "  getHomography: " << allocs[3] / (float) nRuns;
+    
+    if (allocs[1] > 0 || allocs[2] > 0){
+        ofLogError("testAllocations") << "matching / filtering allocated in steady state";
+    }
+    
+    assert(allocs[1] == 0 && allocs[2] == 0); // steady-state matching + filtering allocate nothing
+}
@@ -2,6 +2,9 @@
 
 #include "ofMain.h"
 #include "SIFTMatcher.hpp"
+#include "SIFTTracker.hpp"
+#include "AllocationCounter.hpp"
+#include "MultiMatcher.hpp"
 
 using namespace cv;
 using namespace ofxCv;
@@ -13,6 +16,11 @@ public:
     void update();
     void draw();
     
+    void benchmarkBackends(); // compares feature backends on the test images, results to console
+    void testCompression(); // recall + inliers of compressed descriptors vs raw SIFT, results to console
+    void testAllocations(); // heap allocations per step of repeated matching, results to console
+    void setupMultiDetection(); // several queries for the 'm' multi-object demo
+    
     void keyPressed(int key);
     void keyReleased(int key);
     void mouseMoved(int x, int y );
@@ -25,7 +33,17 @@ public:
     void dragEvent(ofDragInfo dragInfo);
     void gotMessage(ofMessage msg);
     
-    ofImage findImg, fieldImg, matchImg, refImg;
+    ofImage findImg, fieldImg, refImg;
     SIFTMatcher siftMatcher;
     
+    // tracking demo: follows findImg through a simulated camera move over fieldImg
+    SIFTTracker tracker;
+    bool bTracking = false;
+    Mat trackMat; // this frame of the simulated video
+    ofImage trackImg; // trackMat for drawing
+    
+    // multi-object demo: several query images found in fieldImg in one pass
+    MultiMatcher multiMatcher;
+    bool bMulti = false;
+    
 };
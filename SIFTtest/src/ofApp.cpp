@@ -41,14 +41,14 @@ void ofApp::setup(){
     //------------------------------------//
     
     
-    // ---------------------------------------
-    // 1. DETECT SIFT keypoints in both images
-    // ---------------------------------------
+    // -----------------------------------------------------------
+    // 1. DETECT + DESCRIBE SIFT keypoints/features in both images
+    // -----------------------------------------------------------
 
     
-    SiftFeatureDetector detector(2000); // SIFT detector object
+    SIFT sift(2000); // SIFT detector + descriptor object
     
-    // 400 = max number of keypoints to find
+    // 2000 = max number of keypoints to find
             //  all optional constructor args, with default values:
             //      (int nfeatures=0, int nOctaveLayers=3, double contrastThreshold=0.04,
             //       double edgeThreshold=10, double sigma=1.6);
@@ -56,55 +56,35 @@ void ofApp::setup(){
     
     vector<KeyPoint> findKeypoints, fieldKeypoints; // KeyPoint vectors to store keypoints detected per image
     
-    // run the detector on each image
+    Mat findDescriptors, fieldDescriptors; // matrices to hold all features per keypoint in image
+    // i.e. in each matrix, row 'i' is the list of features for keypoint 'i'
+    
+    // run detection + description on each image in one pass
+    // (SiftFeatureDetector::detect + SiftDescriptorExtractor::compute would each build
+    //  their own Gaussian scale-space pyramid for the same image, this builds it once)
     
-    detector.detect(findMat, findKeypoints);
-    detector.detect(fieldMat, fieldKeypoints);
+    sift(findMat, noArray(), findKeypoints, findDescriptors);
+    sift(fieldMat, noArray(), fieldKeypoints, fieldDescriptors);
     
     
     // print results
     // --------------
-    uint64_t detectTime = ofGetElapsedTimeMillis() - startTime; // calculate detection time
+    uint64_t detectTime = ofGetElapsedTimeMillis() - startTime; // calculate detection + description time
     
     // print # keypoints found to console
     
-    ofLogNotice("SIFT Detector") << "took " << detectTime << " ms" << endl << endl
+    ofLogNotice("SIFT Detector + Descriptor") << "took " << detectTime << " ms" << endl << endl
         << "# keypoints found" << endl
         << "-----------------" << endl
         << "  findImg: " << findKeypoints.size() << endl
         << "  fieldImg: " << fieldKeypoints.size() << endl;
     
-    startTime = ofGetElapsedTimeMillis();   // reset startTime
-    // --------------
-
-    
-    // --------------------------------------
-    // 2. DESCRIBE SIFT features of keypoints
-    // --------------------------------------
-    
-    
-    SiftDescriptorExtractor extractor; // SIFT descriptor object
-    
-    
-    Mat findDescriptors, fieldDescriptors; // matrices to hold all features per keypoint in image
-    // i.e. in each matrix, row 'i' is the list of features for keypoint 'i'
-    
-    // run the feature description extractor
-    
-    extractor.compute(findMat, findKeypoints, findDescriptors);
-    extractor.compute(fieldMat, fieldKeypoints, fieldDescriptors);
-    
-    
-    // print results
-    // --------------
-    uint64_t describeTime = ofGetElapsedTimeMillis() - startTime; // calculate description time
-    
     // print some statistics on the matrices
     
     cv::Size findSize = findDescriptors.size(); // size of matrix
     cv::Size fieldSize = fieldDescriptors.size();
     
-    ofLogNotice("SIFT Descriptor") << "took " << describeTime << " ms" << endl << endl
+    ofLogNotice("SIFT Descriptor") << endl
         << "findImg feature matrix" << endl
         << "--------------------" << endl
         << "  height: " << findSize.height << ", width: " << findSize.width << endl
@@ -0,0 +1,180 @@
+//
+//  Benchmark.cpp
+//  benchmarks
+//
+
+#include "Benchmark.hpp"
+
+Benchmark::Benchmark(const string& _label, int _warmup, int _iterations){
+
+    label = _label;
+    setIterations(_warmup, _iterations);
+}
+
+//--------------------------------------------------------------
+void Benchmark::setIterations(int _warmup, int _iterations){
+
+    warmup = max(_warmup, 0);
+    iterations = max(_iterations, 1);
+}
+
+//--------------------------------------------------------------
+Benchmark::Result& Benchmark::run(const string& name, const vector<pair<string, string>>& params, const function<void()>& fn){
+
+    for (int i=0; i<warmup; i++){
+        fn();
+    }
+
+    vector<double> times;
+    times.reserve(iterations);
+
+    for (int i=0; i<iterations; i++){
+        uint64_t start = ofGetElapsedTimeMicros();
+        fn();
+        times.push_back((ofGetElapsedTimeMicros() - start) / 1000.0);
+    }
+
+    return add(name, params, times);
+}
+
+//--------------------------------------------------------------
+Benchmark::Result& Benchmark::add(const string& name, const vector<pair<string, string>>& params, const vector<double>& times){
+
+    Result result;
+    result.name = name;
+    result.params = params;
+    result.times = times;
+    summarize(result);
+
+    results.push_back(result);
+    return results.back();
+}
+
+//--------------------------------------------------------------
+void Benchmark::addCounter(Result& result, const string& name, double value){
+
+    result.counters.push_back(make_pair(name, value));
+}
+
+//--------------------------------------------------------------
+void Benchmark::addInfo(const string& name, const string& value){
+
+    info.push_back(make_pair(name, value));
+}
+
+//--------------------------------------------------------------
+const vector<Benchmark::Result>& Benchmark::getResults() const {
+    return results;
+}
+
+//--------------------------------------------------------------
+void Benchmark::summarize(Result& result){
+
+    if (result.times.empty()) return;
+
+    vector<double> sorted = result.times;
+    sort(sorted.begin(), sorted.end());
+
+    int n = sorted.size();
+    result.minMs = sorted.front();
+    result.maxMs = sorted.back();
+    result.medianMs = (n % 2) ? sorted[n/2] : 0.5 * (sorted[n/2 - 1] + sorted[n/2]);
+    result.meanMs = accumulate(sorted.begin(), sorted.end(), 0.0) / n;
+}
+
+//--------------------------------------------------------------
+void Benchmark::log() const {
+
+    for (auto& r : results){
+
+        string params;
+        for (auto& p : r.params){
+            params += " " + p.first + "=" + p.second;
+        }
+
+        ofLogNotice("Benchmark") << r.name << params
+        << ": median " << ofToString(r.medianMs, 2) << " ms"
+        << " (min " << ofToString(r.minMs, 2) << ", max " << ofToString(r.maxMs, 2)
+        << ", n " << r.times.size() << ")";
+    }
+}
+
+//--------------------------------------------------------------
+string Benchmark::escape(const string& s){
+
+    string out;
+    for (char c : s){
+        if (c == '"' || c == '\\') out += '\\';
+        out += c;
+    }
+    return out;
+}
+
+//--------------------------------------------------------------
+string Benchmark::toJson() const {
+
+    // written by hand, oF 0.9 doesn't come with a JSON library
+
+    stringstream json;
+    json << "{\n";
+    json << "  \"label\": \"" << escape(label) << "\",\n";
+    json << "  \"timestamp\": \"" << ofGetTimestampString("%Y-%m-%dT%H:%M:%S") << "\",\n";
+    json << "  \"warmup\": " << warmup << ",\n";
+    json << "  \"iterations\": " << iterations << ",\n";
+
+    json << "  \"info\": {";
+    for (int i=0; i<info.size(); i++){
+        json << (i ? ", " : "") << "\"" << escape(info[i].first) << "\": \"" << escape(info[i].second) << "\"";
+    }
+    json << "},\n";
+    json << "  \"results\": [\n";
+
+    for (int i=0; i<results.size(); i++){
+
+        const Result& r = results[i];
+
+        json << "    {\n";
+        json << "      \"name\": \"" << escape(r.name) << "\",\n";
+
+        json << "      \"params\": {";
+        for (int j=0; j<r.params.size(); j++){
+            json << (j ? ", " : "") << "\"" << escape(r.params[j].first) << "\": \"" << escape(r.params[j].second) << "\"";
+        }
+        json << "},\n";
+
+        json << "      \"counters\": {";
+        for (int j=0; j<r.counters.size(); j++){
+            json << (j ? ", " : "") << "\"" << escape(r.counters[j].first) << "\": " << r.counters[j].second;
+        }
+        json << "},\n";
+
+        json << "      \"min_ms\": " << r.minMs << ", \"median_ms\": " << r.medianMs
+        << ", \"mean_ms\": " << r.meanMs << ", \"max_ms\": " << r.maxMs << ",\n";
+
+        json << "      \"times_ms\": [";
+        for (int j=0; j<r.times.size(); j++){
+            json << (j ? ", " : "") << r.times[j];
+        }
+        json << "]\n";
+
+        json << "    }" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+
+    json << "  ]\n";
+    json << "}\n";
+
+    return json.str();
+}
+
+//--------------------------------------------------------------
+bool Benchmark::save(const string& path) const {
+
+    ofBuffer buffer;
+    buffer.set(toJson());
+
+    bool bSaved = ofBufferToFile(path, buffer);
+    if (!bSaved){
+        ofLogError("Benchmark") << "couldn't write " << path;
+    }
+    return bSaved;
+}
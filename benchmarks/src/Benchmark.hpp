@@ -0,0 +1,58 @@
+//
+//  Benchmark.hpp
+//  benchmarks
+//
+
+#pragma once
+#include "ofMain.h"
+
+
+// small timing harness for the headless benchmark app:
+// each case runs a few untimed warmup iterations, then is timed per iteration (ofGetElapsedTimeMicros).
+// results keep their parameters (scale, grid size, ...) and any counters the case reports
+// (# keypoints, inliers, ...), and are written out as JSON so runs can be diffed / plotted
+
+class Benchmark {
+
+public:
+
+    struct Result {
+        string name;
+        vector<pair<string, string>> params; // in the order they were added
+        vector<pair<string, double>> counters;
+        vector<double> times; // ms per iteration
+        double minMs = 0, medianMs = 0, meanMs = 0, maxMs = 0;
+    };
+
+    Benchmark(const string& _label = "", int _warmup = 2, int _iterations = 10);
+
+    void setIterations(int _warmup, int _iterations);
+
+    Result& run(const string& name, const vector<pair<string, string>>& params, const function<void()>& fn);
+    // warmup + timed iterations of fn, adds a result and returns it (to add counters)
+
+    Result& add(const string& name, const vector<pair<string, string>>& params, const vector<double>& times);
+    // adds a result from times measured by the caller (cases that can't just repeat one call, like video frames)
+
+    static void addCounter(Result& result, const string& name, double value);
+
+    void addInfo(const string& name, const string& value); // about the whole run (machine, threads...)
+
+    const vector<Result>& getResults() const;
+
+    void log() const; // one line per result to the console
+
+    string toJson() const;
+    bool save(const string& path) const; // toJson() to a file, path relative to bin/data
+
+private:
+
+    static void summarize(Result& result);
+    static string escape(const string& s);
+
+    string label;
+    vector<pair<string, string>> info;
+    int warmup, iterations;
+    vector<Result> results;
+
+};
@@ -0,0 +1,22 @@
+#include "ofMain.h"
+#include "ofAppNoWindow.h"
+#include "ofApp.h"
+
+//========================================================================
+int main(int argc, char* argv[]){
+    
+    // headless: no window or GL context, the benchmarks run in ofApp::setup() and the app exits
+    ofAppNoWindow window;
+    ofSetupOpenGL(&window, 1024,768, OF_WINDOW);
+    
+    ofApp* app = new ofApp();
+    
+    // optional arguments: output file (relative to bin/data), a label for the run and # of threads
+    // e.g. ./benchmarks results/laptop.json "laptop, before grid change" 4
+    if (argc > 1) app->outputPath = argv[1];
+    if (argc > 2) app->label = argv[2];
+    if (argc > 3) app->nThreads = ofToInt(argv[3]);
+    
+    ofRunApp(app);
+    
+}
@@ -0,0 +1,521 @@
+#include "ofApp.h"
+#include <cassert>
+
+// test data lives with the projects that use it, paths relative to this app's bin/data
+static const string siftData = "../../../SIFT_filterMatches_homography/bin/data/";
+static const string histData = "../../../griddedHistogram/bin/data/";
+static const string flowData = "../../../optFlowTest/bin/data/";
+
+//--------------------------------------------------------------
+void ofApp::setup(){
+
+    bench = Benchmark(label, 2, 10); // label, warmup iterations, timed iterations
+
+    TaskScheduler::get().setup(nThreads); // 0 = all cores
+    bench.addInfo("threads", ofToString(TaskScheduler::get().getNumThreads()));
+    bench.addInfo("opencvThreads", ofToString(TaskScheduler::get().getNumOpenCvThreads()));
+
+    uint64_t start = ofGetElapsedTimeMillis();
+
+    benchmarkSIFT();
+    benchmarkBatch();
+    bench.addInfo("histogramCounterCheck", checkHistogramCounter() ? "passed" : "failed");
+    benchmarkHistogrid();
+    benchmarkHistogridLookup();
+    benchmarkFlow();
+    benchmarkFlowBatch();
+    benchmarkFlowSweep();
+
+    bench.log();
+    bench.save(outputPath);
+
+    ofLogNotice("benchmarks") << bench.getResults().size() << " results in "
+    << (ofGetElapsedTimeMillis() - start) / 1000.0 << " s, written to " << ofToDataPath(outputPath, true);
+
+    ofExit();
+}
+
+//--------------------------------------------------------------
+void ofApp::update(){
+
+}
+
+//--------------------------------------------------------------
+void ofApp::loadScaled(ofImage& img, const string& path, int scale){
+
+    img.setUseTexture(false); // no GL context here
+
+    if (!img.load(path)){
+        ofLogError("benchmarks") << "couldn't load " << path;
+        return;
+    }
+
+    if (scale != 1){
+        img.resize(img.getWidth() * scale, img.getHeight() * scale);
+    }
+}
+
+//--------------------------------------------------------------
+void ofApp::benchmarkSIFT(){
+
+    // same setup as the SIFT_filterMatches_homography app, at each scale and keypoint cap
+
+    vector<int> maxFeatures = {500, 2000};
+
+    for (int scale : scales){
+
+        ofImage findImg, fieldImg;
+        loadScaled(findImg, siftData + "peeping_tom_crop2-3d.jpg", scale);
+        loadScaled(fieldImg, siftData + "peeping_tom_scene.jpg", scale);
+
+        if (!findImg.isAllocated() || !fieldImg.isAllocated()) return;
+
+        for (int nFeatures : maxFeatures){
+
+            SIFTMatcher matcher(findImg, fieldImg);
+            matcher.setLogging(false);
+            matcher.setFeatureBackend(FEATURE_SIFT, nFeatures);
+
+            vector<pair<string, string>> params = {
+                {"scale", ofToString(scale)},
+                {"maxFeatures", ofToString(nFeatures)},
+                {"fieldSize", ofToString(fieldImg.getWidth()) + "x" + ofToString(fieldImg.getHeight())}
+            };
+
+            // each step on the output of the previous one, all three repeat without changing their input
+
+            Benchmark::Result& match = bench.run("sift.match", params, [&]{ matcher.match(); });
+            Benchmark::addCounter(match, "findKeypoints", matcher.findKeypoints.size());
+            Benchmark::addCounter(match, "fieldKeypoints", matcher.fieldKeypoints.size());
+            Benchmark::addCounter(match, "matches", matcher.matches.size());
+
+            Benchmark::Result& filter = bench.run("sift.filterMatches", params, [&]{ matcher.filterMatches(); });
+            Benchmark::addCounter(filter, "goodMatches", matcher.goodMatches.size());
+
+            bool bFound = false;
+            Benchmark::Result& homography = bench.run("sift.getHomography", params, [&]{ bFound = matcher.getHomography(true); });
+            Benchmark::addCounter(homography, "found", bFound);
+            Benchmark::addCounter(homography, "inliers", matcher.getNumInliers());
+            Benchmark::addCounter(homography, "reprojectionError", matcher.getReprojectionError());
+        }
+    }
+}
+
+//--------------------------------------------------------------
+void ofApp::benchmarkBatch(){
+
+    // a batch job: find the crop in every image of a list, each decoded from disk.
+    // in line = imread, then match, one after the other
+    // prefetched = ImageLoader decodes the next images while the current one is matched
+
+    vector<string> names = {"peeping_tom_scene.jpg", "peeping_tom_crop1.jpg", "peeping_tom_crop2.jpg", "peeping_tom_crop1-3d.jpg"};
+    vector<string> paths;
+    for (int i=0; i<12; i++){
+        paths.push_back(siftData + names[i % names.size()]);
+    }
+
+    Mat findMat = imread(ofToDataPath(siftData + "peeping_tom_crop2-3d.jpg", true), CV_LOAD_IMAGE_GRAYSCALE);
+    if (findMat.empty()){
+        ofLogError("benchmarks") << "couldn't load " << siftData << "peeping_tom_crop2-3d.jpg";
+        return;
+    }
+
+    SIFTMatcher matcher;
+    matcher.setLogging(false);
+
+    vector<pair<string, string>> params = {{"images", ofToString(paths.size())}};
+
+    bench.setIterations(1, 3); // whole batches, keep it short
+
+    bench.run("batch.inline", params, [&]{
+        for (auto& path : paths){
+            Mat fieldMat = imread(ofToDataPath(path, true), CV_LOAD_IMAGE_GRAYSCALE);
+            matcher.match(findMat, fieldMat);
+        }
+    });
+
+    ImageLoader loader;
+    loader.setup(2, 4); // 2 decode threads, up to 4 images ahead
+
+    Benchmark::Result& prefetched = bench.run("batch.prefetched", params, [&]{
+        loader.start(paths);
+        ImageLoader::Item item;
+        while (loader.next(item)){
+            matcher.match(findMat, item.mat);
+        }
+    });
+    Benchmark::addCounter(prefetched, "lastWaitMs", loader.getWaitMicros() / 1000.0); // time the last batch waited on decoding
+
+    bench.setIterations(2, 10);
+}
+
+//--------------------------------------------------------------
+// the obvious histogram: one pixel at a time, bin by division. what the counters are checked against
+
+template<typename Pixel>
+static void naiveCount(const Mat& region, int nBins, vector<uint32_t>& counts){
+
+    counts.assign(nBins, 0);
+
+    for (int y=0; y<region.rows; y++){
+        for (int x=0; x<region.cols; x++){
+            int value = region.at<Pixel>(y, x);
+            if (value <= 255) counts[value * nBins / 256]++;
+        }
+    }
+}
+
+template<typename Pixel, int NBins>
+static bool checkCounter(const Mat& region){
+
+    uint32_t counts[NBins];
+    HistogramCounter<Pixel, NBins>::count(region, counts);
+
+    vector<uint32_t> naive;
+    naiveCount<Pixel>(region, NBins, naive);
+
+    if (!equal(naive.begin(), naive.end(), counts)){
+        ofLogError("benchmarks") << "HistogramCounter<" << sizeof(Pixel) * 8 << " bit, " << NBins << " bins> is off on a "
+        << region.cols << "x" << region.rows << " region";
+        return false;
+    }
+    return true;
+}
+
+//--------------------------------------------------------------
+bool ofApp::checkHistogramCounter(){
+
+    // random images with a flat patch (runs of one value, what the sub-histograms are for),
+    // whole and as an odd-sized view (row tails, rows that aren't contiguous).
+    // 16-bit values go past 255, those aren't counted
+
+    RNG rng(0); // same images every run
+
+    Mat img8(203, 301, CV_8UC1), img16(203, 301, CV_16UC1);
+    rng.fill(img8, RNG::UNIFORM, 0, 256);
+    rng.fill(img16, RNG::UNIFORM, 0, 400);
+    img8(cv::Rect(20, 30, 120, 80)).setTo(137);
+    img16(cv::Rect(20, 30, 120, 80)).setTo(137);
+
+    bool bPassed = true;
+
+    for (const Mat& region : {img8, img8(cv::Rect(3, 5, 97, 61))}){
+        bPassed &= checkCounter<uchar, 256>(region);
+        bPassed &= checkCounter<uchar, 128>(region);
+        bPassed &= checkCounter<uchar, 64>(region);
+        bPassed &= checkCounter<uchar, 32>(region);
+        bPassed &= checkCounter<uchar, 16>(region);
+        bPassed &= checkCounter<uchar, 10>(region); // not one Histogrid uses, the generic bin math
+    }
+    for (const Mat& region : {img16, img16(cv::Rect(3, 5, 97, 61))}){
+        bPassed &= checkCounter<ushort, 256>(region);
+        bPassed &= checkCounter<ushort, 64>(region);
+    }
+
+
+    // Histogrid's cells in each counting mode (and calcHist for a bin count it doesn't count itself)
+
+    vector<uint32_t> naive;
+
+    for (int nBins : {256, 64, 16, 100}){
+        for (string counting : {"HistogramCounter", "calcHist", "lazy"}){
+
+            Histogrid hist(7, 5, nBins); // cells don't divide the image evenly
+            hist.setUseCalcHist(counting == "calcHist");
+            hist.setLazy(counting == "lazy");
+            hist.run(img8);
+
+            const vector<ofRectangle>& rects = hist.getRectangles();
+
+            for (int n=0; n<rects.size(); n++){
+
+                naiveCount<uchar>(img8(cv::Rect(rects[n].x, rects[n].y, rects[n].width, rects[n].height)), nBins, naive);
+
+                if (!equal(naive.begin(), naive.end(), hist.getCounts(n))){
+                    ofLogError("benchmarks") << "Histogrid cell " << n << " counted with " << counting << " (" << nBins << " bins) is off";
+                    bPassed = false;
+                    break;
+                }
+            }
+        }
+    }
+
+    ofLogNotice("benchmarks") << "HistogramCounter check " << (bPassed ? "passed" : "FAILED");
+
+    assert(bPassed);
+    return bPassed;
+}
+
+//--------------------------------------------------------------
+void ofApp::benchmarkHistogrid(){
+
+    vector<int> divs = {2, 10, 32, 200}; // grid is divs x divs
+
+    for (int scale : scales){
+
+        ofImage img;
+        loadScaled(img, histData + "img.jpg", scale);
+
+        if (!img.isAllocated()) return;
+
+        for (int nDivs : divs){
+
+            for (string counting : {"HistogramCounter", "calcHist", "lazy"}){
+
+                Histogrid hist(img, nDivs, nDivs, 256);
+                hist.setUseCalcHist(counting == "calcHist"); // integer counting vs calcHist
+                hist.setLazy(counting == "lazy");
+
+                vector<pair<string, string>> params = {
+                    {"scale", ofToString(scale)},
+                    {"grid", ofToString(nDivs) + "x" + ofToString(nDivs)},
+                    {"imgSize", ofToString(img.getWidth()) + "x" + ofToString(img.getHeight())},
+                    {"counting", counting}
+                };
+
+                // imgChanged() every time, so the grayscale conversion is part of each run like a new video frame.
+                // normalizing is on access now, so that's included too: every cell like the old run(),
+                // or in lazy mode just one, like griddedHistogram showing the cell under the mouse
+
+                Benchmark::Result& result = bench.run("histogrid.run", params, [&]{
+                    hist.imgChanged();
+                    hist.run();
+                    if (counting == "lazy") hist.getHistogram(0);
+                    else hist.getHistograms();
+                });
+                Benchmark::addCounter(result, "cells", hist.getHistograms().size());
+            }
+        }
+    }
+}
+
+//--------------------------------------------------------------
+void ofApp::benchmarkHistogridLookup(){
+
+    // finding the cell under 10000 random points (griddedHistogram's mouseMoved):
+    // getCellAt vs the linear search through the rectangles it replaced
+
+    ofImage img;
+    loadScaled(img, histData + "img.jpg", 1);
+
+    if (!img.isAllocated()) return;
+
+    ofSeedRandom(0);
+    vector<ofVec2f> points(10000);
+    for (auto& point : points){
+        point.set(ofRandom(img.getWidth()), ofRandom(img.getHeight()));
+    }
+
+    for (int nDivs : {10, 200}){
+
+        Histogrid hist(img, nDivs, nDivs, 256);
+        hist.setLazy(true); // only the grid is needed
+        hist.run();
+
+        const vector<ofRectangle>& rects = hist.getRectangles();
+
+        vector<pair<string, string>> params = {
+            {"grid", ofToString(nDivs) + "x" + ofToString(nDivs)},
+            {"points", ofToString(points.size())}
+        };
+
+        int nFound = 0;
+
+        params.push_back({"lookup", "getCellAt"});
+        Benchmark::Result& lookup = bench.run("histogrid.lookup", params, [&]{
+            nFound = 0;
+            for (auto& point : points){
+                nFound += hist.getCellAt(point.x, point.y) >= 0;
+            }
+        });
+        Benchmark::addCounter(lookup, "found", nFound);
+
+        params.back().second = "linear";
+        Benchmark::Result& linear = bench.run("histogrid.lookup", params, [&]{
+            nFound = 0;
+            for (auto& point : points){
+                for (int i=0; i<rects.size(); i++){
+                    if (rects[i].inside(point.x, point.y)){
+                        nFound++;
+                        break;
+                    }
+                }
+            }
+        });
+        Benchmark::addCounter(linear, "found", nFound);
+    }
+}
+
+//--------------------------------------------------------------
+void ofApp::benchmarkFlow(){
+
+    // decode the frames once up front, so only the flow is timed
+
+    const int nFrames = 30;
+
+    ofVideoPlayer vid;
+    vid.setUseTexture(false);
+
+    if (!vid.load(flowData + "rearWindow_clip_1-240p.mp4")){
+        ofLogError("benchmarks") << "couldn't load " << flowData << "rearWindow_clip_1-240p.mp4";
+        return;
+    }
+
+    vector<Mat> frames;
+    vid.play();
+    vid.setPaused(true);
+
+    // step through the clip frame by frame (paused + nextFrame), giving up if the decoder stalls
+    int attempts = 0;
+    while (frames.size() < nFrames && !vid.getIsMovieDone() && attempts < nFrames * 100){
+
+        vid.update();
+        attempts++;
+
+        if (vid.isFrameNew()){
+            Mat gray;
+            cvtColor(toCv(vid.getPixels()), gray, CV_RGB2GRAY);
+            frames.push_back(gray);
+            vid.nextFrame();
+        } else {
+            ofSleepMillis(1);
+        }
+    }
+
+    vid.close();
+
+    if (frames.size() < 2){
+        ofLogError("benchmarks") << "not enough video frames decoded for flow";
+        return;
+    }
+
+    for (int scale : scales){
+
+        vector<Mat> scaled(frames.size());
+        for (int i=0; i<frames.size(); i++){
+            if (scale == 1) scaled[i] = frames[i];
+            else resize(frames[i], scaled[i], cv::Size(), scale, scale, INTER_LINEAR);
+        }
+
+        FlowSettings settings; // optFlowTest's default settings
+        FlowFarneback flow;
+        settings.apply(flow);
+
+        // one pass over the clip to warm up, then time each frame of a second pass.
+        // the first frame of a pass only sets the previous frame, so it isn't timed
+
+        for (auto& frame : scaled){
+            flow.calcOpticalFlow(frame);
+        }
+        flow.resetFlow();
+
+        vector<double> times;
+        for (int i=0; i<scaled.size(); i++){
+            uint64_t start = ofGetElapsedTimeMicros();
+            flow.calcOpticalFlow(scaled[i]);
+            if (i > 0) times.push_back((ofGetElapsedTimeMicros() - start) / 1000.0);
+        }
+
+        vector<pair<string, string>> params = {
+            {"scale", ofToString(scale)},
+            {"frameSize", ofToString(scaled[0].cols) + "x" + ofToString(scaled[0].rows)},
+            {"winSize", ofToString(settings.winSize)},
+            {"levels", ofToString(settings.levels)}
+        };
+
+        Benchmark::Result& result = bench.add("flow.farneback", params, times);
+        Benchmark::addCounter(result, "frames", times.size());
+    }
+}
+
+//--------------------------------------------------------------
+void ofApp::benchmarkFlowBatch(){
+
+    // the first 240 frames of the clip in 8 segments, decoded + analyzed in the workers.
+    // once on a single thread, then on all of them: how well whole-film analysis scales
+
+    const string path = flowData + "rearWindow_clip_1-240p.mp4";
+
+    if (FlowBatch::getFrameCount(path) < 240){
+        ofLogError("benchmarks") << "couldn't open " << path << " with cv::VideoCapture (or it's too short), skipping flow batch";
+        return;
+    }
+
+    int nThreads = TaskScheduler::get().getNumThreads();
+    vector<int> threadCounts = {1, nThreads};
+    if (nThreads == 1) threadCounts.pop_back();
+
+    bench.setIterations(1, 3);
+
+    for (int threads : threadCounts){
+
+        TaskScheduler::get().setup(threads, TaskScheduler::get().getNumOpenCvThreads());
+
+        FlowBatch batch;
+        batch.setup(FlowSettings()); // optFlowTest's defaults
+        batch.addSegments(path, 8, 0, 240);
+
+        vector<pair<string, string>> params = {
+            {"threads", ofToString(threads)},
+            {"segments", "8"},
+            {"frames", "240"}
+        };
+
+        Benchmark::Result& result = bench.run("flow.batch", params, [&]{ batch.run(); });
+        Benchmark::addCounter(result, "framesWithFlow", batch.getResults().size());
+
+        // the same frames out of a FrameCache (built once, before the first run): no decoding in the workers
+
+        if (FrameCache::build(path, "cache/rearWindow_240.frames", 1, 0, 240)){
+
+            FlowBatch cachedBatch;
+            cachedBatch.setup(FlowSettings());
+            cachedBatch.addCachedSegments("cache/rearWindow_240.frames", 8);
+
+            Benchmark::Result& cached = bench.run("flow.batch.cached", params, [&]{ cachedBatch.run(); });
+            Benchmark::addCounter(cached, "framesWithFlow", cachedBatch.getResults().size());
+        }
+    }
+
+    TaskScheduler::get().setup(nThreads, TaskScheduler::get().getNumOpenCvThreads()); // back to the run's settings
+    bench.setIterations(2, 10);
+}
+
+//--------------------------------------------------------------
+void ofApp::benchmarkFlowSweep(){
+
+    // a small grid around optFlowTest's defaults over the first 30 frames (from a FrameCache),
+    // each config's time per frame and how far its flow is from the defaults' flow
+
+    const string path = flowData + "rearWindow_clip_1-240p.mp4";
+
+    FrameCache cache;
+    if (!FrameCache::build(path, "cache/rearWindow_30.frames", 1, 0, 30) || !cache.open("cache/rearWindow_30.frames")){
+        ofLogError("benchmarks") << "couldn't cache " << path << ", skipping flow sweep";
+        return;
+    }
+
+    FlowSweep sweep;
+    sweep.setReference(FlowSettings());
+    sweep.addGrid({}, {2, 4}, {1, 2}, {5, 7}, {}, {16, 32});
+
+    if (!sweep.run(cache)) return;
+    sweep.log();
+
+    // the grid includes the defaults themselves, as a check (error ~0)
+
+    for (auto& config : sweep.getResults()){
+
+        vector<pair<string, string>> params = {
+            {"frameSize", ofToString(cache.getWidth()) + "x" + ofToString(cache.getHeight())},
+            {"levels", ofToString(config.settings.levels)},
+            {"iterations", ofToString(config.settings.iterations)},
+            {"polyN", ofToString(config.settings.polyN)},
+            {"winSize", ofToString(config.settings.winSize)}
+        };
+
+        Benchmark::Result& result = bench.add("flow.sweep", params, config.frameMs);
+        Benchmark::addCounter(result, "meanError", config.meanError);
+        Benchmark::addCounter(result, "closeRatio", config.closeRatio);
+    }
+}
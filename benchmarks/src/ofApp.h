@@ -0,0 +1,45 @@
+#pragma once
+
+#include "ofMain.h"
+#include "ofxOpenCv.h"
+#include "ofxCv.h"
+
+#include "Benchmark.hpp"
+#include "SIFTMatcher.hpp"
+#include "Histogrid.hpp"
+#include "ImageLoader.hpp"
+#include "TaskScheduler.hpp"
+#include "FlowBatch.hpp"
+#include "FrameCache.hpp"
+#include "FlowSweep.hpp"
+
+using namespace cv;
+using namespace ofxCv;
+
+class ofApp : public ofBaseApp{
+    
+public:
+    void setup();
+    void update();
+    
+    void benchmarkSIFT(); // match / filterMatches / getHomography on the SIFT_filterMatches_homography test images
+    void benchmarkBatch(); // SIFT over a list of images, decoding in line vs prefetched by ImageLoader
+    bool checkHistogramCounter(); // HistogramCounter and Histogrid's counts vs a naive per-pixel count, before timing them
+    void benchmarkHistogrid(); // Histogrid::run on the griddedHistogram test image, several grid sizes
+    void benchmarkHistogridLookup(); // cell under a point, Histogrid::getCellAt vs searching the rectangles
+    void benchmarkFlow(); // Farneback flow on frames of the optFlowTest clip
+    void benchmarkFlowBatch(); // FlowBatch over segments of the optFlowTest clip, 1 thread vs all, decoded vs from a FrameCache
+    void benchmarkFlowSweep(); // FlowSweep over a grid of Farneback settings, time and error vs the defaults per config
+    
+    void loadScaled(ofImage& img, const string& path, int scale);
+    // loads path (no texture, headless) and scales it up by scale
+    
+    string outputPath = "benchmarks.json"; // relative to bin/data
+    string label;
+    int nThreads = 0; // for the TaskScheduler, 0 = one per core
+    
+    vector<int> scales = {1, 2, 4}; // every case runs on the test data at 1x, 2x and 4x size
+    
+    Benchmark bench;
+    
+};
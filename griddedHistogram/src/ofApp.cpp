@@ -14,6 +14,8 @@ void ofApp::setup(){
     
     hist = Histogrid(img,nDivsX,nDivsY,256); //img, nDivs x,y, nBins
     
+    hist.setLazy(true); // only the cell under the mouse is drawn, so cells are counted when first drawn
+    
     hist.run(); // calculate the histogram
     
     rects = hist.getRectangles(); // get the grid as a vector of rectangles
@@ -70,18 +72,16 @@ void ofApp::mouseMoved(int x, int y ){
     if (rect.inside(ofVec2f(x,y))){
         
         // figure out which rectangle the mouse is in
+        // (mouse from the drawn image's bounds to image pixels)
+        
+        float mX = ofMap(x, imgXY.x, imgXY.x + imgWH.x, 0, img.getWidth());
+        float mY = ofMap(y, imgXY.y, imgXY.y + imgWH.y, 0, img.getHeight());
         
-        float mX = ofMap(x, imgXY.x, imgWH.x, 0, img.getWidth());
-        float mY = ofMap(y, imgXY.y, imgWH.y, 0, img.getHeight());
+        int cell = hist.getCellAt(mX, mY); // -1 in the leftover pixels past the last cells
         
-        for (int i=0; i<rects.size(); i++){
-            
-            if (rects[i].inside(mX,mY)){
-                gridNum = i;
-                drawGrid = rects[i];
-
-                break;
-            }
+        if (cell >= 0){
+            gridNum = cell;
+            drawGrid = rects[cell];
         }
     }
 
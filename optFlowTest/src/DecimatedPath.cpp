@@ -0,0 +1,76 @@
+//
+//  DecimatedPath.cpp
+//  optFlowTest
+//
+
+#include "DecimatedPath.hpp"
+
+
+DecimatedPath::DecimatedPath(){
+}
+
+void DecimatedPath::setup(int _nRecent, int _maxHistory, float _tolerance){
+
+    nRecent = max(2, _nRecent);
+    maxHistory = max(2, _maxHistory);
+    // tolerance doubles whenever the history is too long, from 0 it would never grow
+    startTolerance = tolerance = max(0.01f, _tolerance);
+
+    clear();
+}
+
+void DecimatedPath::addVertex(const ofVec2f& pt){
+
+    recent.addVertex(pt);
+
+    if (recent.size() < nRecent * 2) return;
+
+
+    // move the oldest nRecent vertices into the history, simplified
+    // (only every nRecent frames, so the cost per frame stays constant)
+
+    vector<ofPoint>& verts = recent.getVertices();
+
+    chunk.clear();
+    chunk.addVertices(&verts[0], nRecent + 1); // overlap by one so history and recent stay joined
+    chunk.simplify(tolerance);
+
+    if (history.size() > 0){
+        history.getVertices().insert(history.getVertices().end(), chunk.getVertices().begin() + 1, chunk.getVertices().end());
+        history.flagHasChanged();
+    } else {
+        history = chunk;
+    }
+
+    verts.erase(verts.begin(), verts.begin() + nRecent);
+    recent.flagHasChanged();
+
+
+    // history too long: coarsen it as a whole
+
+    while (history.size() > maxHistory){
+        tolerance *= 2;
+        history.simplify(tolerance);
+    }
+}
+
+void DecimatedPath::clear(){
+
+    recent.clear();
+    history.clear();
+    tolerance = startTolerance;
+}
+
+void DecimatedPath::draw() const{
+
+    history.draw();
+    recent.draw();
+}
+
+int DecimatedPath::size() const{
+    return recent.size() + history.size();
+}
+
+float DecimatedPath::getTolerance() const{
+    return tolerance;
+}
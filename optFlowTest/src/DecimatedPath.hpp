@@ -0,0 +1,41 @@
+//
+//  DecimatedPath.hpp
+//  optFlowTest
+//
+
+#pragma once
+#include "ofMain.h"
+
+
+// polyline with bounded size for paths that grow every frame
+// the most recent vertices are kept exactly, older ones are
+// simplified (Douglas-Peucker, via ofPolyline::simplify) in chunks as they age,
+// and the tolerance doubles whenever the simplified history gets too long again
+
+class DecimatedPath {
+
+public:
+
+    DecimatedPath();
+
+    void setup(int _nRecent = 300, int _maxHistory = 500, float _tolerance = 0.5);
+    // nRecent = # of newest vertices kept untouched (up to 2x this before a chunk is moved)
+    // maxHistory = max # of vertices in the simplified history
+    // tolerance = starting simplify tolerance, in px (at least 0.01, as good as exact on screen)
+
+    void addVertex(const ofVec2f& pt);
+    void clear();
+
+    void draw() const;
+
+    int size() const; // # of vertices currently stored
+    float getTolerance() const;
+
+private:
+
+    int nRecent = 300, maxHistory = 500;
+    float startTolerance = 0.5, tolerance = 0.5;
+
+    ofPolyline recent, history, chunk;
+
+};
@@ -22,6 +22,29 @@ void ofApp::setup(){
     gui.add(loopVid.set("Loop video", false));
     gui.add(vidScale.set("Scale video", 2, 1, 3));
     gui.add(lineWidth.set("Draw line width", 4, 1, 10));
+    gui.add(useRobustMotion.set("Robust camera motion", true));
+    gui.add(drawFlowStats.set("Draw flow stats", false));
+    
+    // flow stats: 16 magnitude bins up to 8px/frame, 16 direction bins, 4x4 regions
+    flowStats.setup(16, 8, 16, 4, 4);
+    
+    // motion descriptor: 4x4 cells * (mean x,y + 8 orientation bins) = 160 bytes per frame
+    flowDescriptor.setup(4, 4, 8);
+    motionIndex.setup(flowDescriptor.size());
+    
+    // keep per-frame history bounded, so long videos don't grow memory or draw time
+    frameFlows.setCapacity(600); // ~10 sec at 60fps
+    frameMotions.setCapacity(600);
+    dotPath.setup(300, 500, 0.5); // 300 exact recent points, max 500 simplified older points
+    
+    // cut detection on a 64x36 thumbnail histogram (32 bins)
+    cutDetector.setup(0.35, 4, 8, 64, 36, 32);
+    
+    // camera motion: similarity model (translation, rotation, zoom) fit to every 8th flow vector
+    motionEstimator.setup(8, FlowMotionEstimator::MOTION_SIMILARITY);
+    
+    // per-frame analysis runs as tasks on every core, OpenCV's own threads capped so they don't compete
+    TaskScheduler::get().setup();
     
     // start video
     vid.play();
@@ -51,6 +74,8 @@ void ofApp::update(){
         
         if (vid.getIsMovieDone()){
             flow.resetFlow(); // reset flow cache in ofxCv to clear flow draw
+            bHasPrevFrame = false;
+            finishShot(vid.getTotalNumFrames()); // save the last shot (once)
         }
     }
 
@@ -86,22 +111,74 @@ void ofApp::update(){
         
         
         
+        // check for a cut first, so flow isn't calculated across it
+        
+        if (cutDetector.update(toCv(vid.getPixels()))){
+            startShot(vid.getCurrentFrame());
+        }
+        
+        
         // calculate flow
         
         flow.calcOpticalFlow(vid);
         
+        // the first frame after a reset or cut has nothing in its shot to be measured against
+        // (resetFlow() doesn't release the old flow field, so getWidth() can't tell), it's only next frame's previous one
+        
+        bool bHasFlow = bHasPrevFrame;
+        bHasPrevFrame = true;
+        
+        if (!bHasFlow) return;
+        
+        
+        
+        // stats, descriptor and camera motion only read the flow field,
+        // so they run side by side as tasks (the motion estimator's RANSAC splits into more tasks itself)
+        
+        const Mat& flowMat = flow.getFlow();
+        
+        TaskGroup analysis;
+        
+        // flow statistics in one pass
+        // (includes the average, so no separate getAverageFlow() pass)
+        analysis.run([&]{ flowStats.run(flowMat); });
+        
+        // gridded motion descriptor for the similarity index
+        analysis.run([&]{ flowDescriptor.compute(flowMat); });
+        
+        // camera motion, ignoring foreground movement that doesn't fit the global model
+        analysis.run([&]{ motionEstimator.estimate(flowMat); });
+        
+        analysis.wait();
         
         
         // save average flows per frame + per vid
         
-        frameFlows.push_back(flow.getAverageFlow());
+        frameFlows.push_back(toOf(flowStats.getAverage()));
+        
+        // add this frame's motion to the index
+        
+        flowDescriptor.quantize(motionCode);
+        motionIndex.add(motionCode, 0, vid.getCurrentFrame());
+        
+        vidFlowStats.add(toCv(frameFlows.back()));
+        vidFlowAvg = toOf(vidFlowStats.getMean());
+        
+        frameMotions.push_back(motionEstimator.getMotion());
+        
+        // per-shot stats
         
-        vidFlowTotal += frameFlows.back();
-        vidFlowAvg = vidFlowTotal / frameFlows.size();
+        shotFlowStats.add(toCv(frameFlows.back()));
+        currentShot.cameraTravel += frameMotions.back().translation;
+        shotZoomTotal += frameMotions.back().zoom;
         
         // calculate dot position to show average movement
         
-        dotPos += frameFlows.back();
+        if (useRobustMotion){
+            dotPos += toOf(frameMotions.back().translation);
+        } else {
+            dotPos += frameFlows.back();
+        }
         dotPath.addVertex(dotPos);
         
     }
@@ -138,6 +215,22 @@ void ofApp::draw(){
     
         dotPath.draw(); // draw dot's path
     
+        if (drawFlowStats && frameFlows.size() > 0){
+            
+            // draw average flow per region, from region center
+            
+            ofSetColor(255,255,0);
+            
+            const vector<Point2f>& regionAvgs = flowStats.getRegionAverages();
+            float sx = vidW / flow.getWidth(), sy = vidH / flow.getHeight(); // flow coords -> video coords
+            
+            for (int i=0; i<regionAvgs.size(); i++){
+                ofVec2f c = flowStats.getRegion(i).getCenter();
+                c.x *= sx; c.y *= sy;
+                ofDrawLine(c, c + toOf(regionAvgs[i]) * 20); // scale * 20 for visibility
+            }
+        }
+    
         if (frameFlows.size() > 0){
         // draw average magnitude and direction of this frame, if we have it
     
@@ -181,9 +274,26 @@ void ofApp::draw(){
         
             ofDrawBitmapStringHighlight("Avg magnitude + direction\nnorm'd to 50px",-115,-50);
         
+            ofVec2f sd = toOf(vidFlowStats.getStdDev());
+            ofDrawBitmapStringHighlight("shot " + ofToString(shots.size() + 1) + ", cut diff " + ofToString(cutDetector.getDifference(), 2), -115, 85);
+            ofDrawBitmapStringHighlight("std dev: " + ofToString(sd.x, 2) + ", " + ofToString(sd.y, 2), -115, 70);
+        
+            // print this frame's camera motion
+        
+            const FlowMotion& m = frameMotions.back();
+            ofDrawBitmapStringHighlight("Camera motion\n"
+                                        "  translate: " + ofToString(m.translation.x, 2) + ", " + ofToString(m.translation.y, 2) + "\n"
+                                        "  rotate: " + ofToString(ofRadToDeg(m.rotation), 3) + " deg\n"
+                                        "  zoom: " + ofToString(m.zoom, 4) + "\n"
+                                        "  inliers: " + ofToString((int) (m.inlierRatio * 100)) + "%", -115, 100);
+        
         
         ofPopMatrix();
         
+        if (drawFlowStats){
+            flowStats.drawHistograms(10, 480, 230, 200); // below the camera motion text
+        }
+        
     }
     
 
@@ -193,10 +303,13 @@ void ofApp::draw(){
 void ofApp::reset(){
     
     flow.resetFlow(); // clear ofxCv's flow cache
+    bHasPrevFrame = false;
     
     // reset frameFlow tracking
     frameFlows.clear();
-    vidFlowTotal.set(0,0);
+    frameMotions.clear();
+    motionIndex.clear();
+    vidFlowStats.clear();
     
     // moving dot
     dotPos = ofVec2f(vidW*0.5, vidH*0.5); // center of drawn video
@@ -204,10 +317,94 @@ void ofApp::reset(){
     // polyline that tracks dot movement
     dotPath.clear();
     dotPath.addVertex(dotPos);
+    
+    // shots
+    // the open shot ran to the end of the video (looped), finish it and keep the pass's shots for printing
+    finishShot(vid.getTotalNumFrames()); // nothing to finish if no frames were analyzed since the last reset
+    if (shots.size() > 0) prevShots = shots;
+    
+    cutDetector.reset();
+    shots.clear();
+    shotFlowStats.clear();
+    shotZoomTotal = 0;
+    currentShot = ShotSummary();
+}
+
+//--------------------------------------------------------------
+void ofApp::startShot(int frame){
+    
+    finishShot(frame);
+    
+    flow.resetFlow(); // previous frame is from another shot, don't calc flow against it
+    bHasPrevFrame = false; // and this frame isn't analyzed
+    
+    currentShot.startFrame = frame;
+    
+    ofLogNotice("SceneCutDetector") << "cut at frame " << frame << " (diff " << cutDetector.getDifference() << ")";
+}
+
+//--------------------------------------------------------------
+void ofApp::finishShot(int endFrame){
+    
+    if (shotFlowStats.getCount() == 0) return; // nothing analyzed since the last cut
+    
+    currentShot.endFrame = endFrame;
+    currentShot.meanFlow = shotFlowStats.getMean();
+    currentShot.flowStdDev = shotFlowStats.getStdDev();
+    currentShot.meanMagnitude = shotFlowStats.getMeanMagnitude();
+    currentShot.meanZoom = shotZoomTotal / shotFlowStats.getCount();
+    
+    shots.push_back(currentShot);
+    
+    // start the next one
+    shotFlowStats.clear();
+    shotZoomTotal = 0;
+    currentShot = ShotSummary();
+    currentShot.startFrame = endFrame;
+}
+
+//--------------------------------------------------------------
+void ofApp::logShots(const vector<ShotSummary>& shotList){
+    
+    for (int i=0; i<shotList.size(); i++){
+        ofLogNotice("shot " + ofToString(i)) << "frames " << shotList[i].startFrame << "-" << shotList[i].endFrame
+        << ", mean flow " << shotList[i].meanFlow << " (std dev " << shotList[i].flowStdDev << ")"
+        << ", mean magnitude " << shotList[i].meanMagnitude
+        << ", camera travel " << shotList[i].cameraTravel
+        << ", mean zoom " << shotList[i].meanZoom;
+    }
 }
 
 //--------------------------------------------------------------
 void ofApp::keyPressed(int key){
+    
+    if (key == 'f' && motionIndex.size() > 0){
+        
+        // find the frames with motion most like the current frame
+        
+        vector<FlowDescriptorIndex::Match> similar;
+        motionIndex.search(motionCode, 6, similar); // first result is the current frame itself
+        
+        for (int i=0; i<similar.size(); i++){
+            ofLogNotice("motionIndex") << "frame " << similar[i].frame << ", distance " << similar[i].distance;
+        }
+    }
+    
+    if (key == 's'){
+        motionIndex.save("motionIndex.bin"); // save descriptors of all frames so far
+    }
+    
+    if (key == 'p'){
+        
+        // print per-shot motion summaries (of the last full pass too, if the video looped)
+        
+        if (prevShots.size() > 0){
+            ofLogNotice("shots") << "previous pass:";
+            logShots(prevShots);
+            ofLogNotice("shots") << "this pass:";
+        }
+        logShots(shots);
+    }
 
 }
 
@@ -7,6 +7,14 @@
 
 #include "ofxGui.h"
 
+#include "FlowMotionEstimator.hpp"
+#include "FlowStats.hpp"
+#include "FlowDescriptor.hpp"
+#include "FlowAccumulator.hpp"
+#include "DecimatedPath.hpp"
+#include "SceneCutDetector.hpp"
+#include "TaskScheduler.hpp"
+
 using namespace cv;
 using namespace ofxCv;
 
@@ -18,6 +26,9 @@ public:
     void draw();
     
     void reset();
+    void startShot(int frame); // call on a cut: resets flow + per-shot stats
+    void finishShot(int endFrame); // saves the current shot's summary to shots
+    void logShots(const vector<ShotSummary>& shotList);
 
     void keyPressed(int key);
     void keyReleased(int key);
@@ -37,12 +48,30 @@ public:
     FlowFarneback flow; // ofxCv's dense optical flow analyzer (for whole image)
     // alternative would be FlowPyrLK which detects/analyzes a sparse feature set
     
-    vector<ofVec2f> frameFlows; // store average flow frame-by-frame
-    ofVec2f vidFlowTotal = ofVec2f(0,0), vidFlowAvg = ofVec2f(0,0); // store average flow of video
+    FlowStats flowStats; // per-frame histograms + region averages, one pass over the flow field
+    
+    FlowDescriptor flowDescriptor; // gridded mean flow + oriented flow histogram per frame
+    FlowDescriptorIndex motionIndex; // quantized descriptors of every frame, for similarity search
+    vector<uchar> motionCode; // this frame's quantized descriptor
+    
+    RingBuffer<ofVec2f> frameFlows; // store average flow of the most recent frames
+    
+    FlowMotionEstimator motionEstimator; // robust global (camera) motion fit to the flow field
+    RingBuffer<FlowMotion> frameMotions; // store camera motion of the most recent frames
+    FlowAccumulator vidFlowStats; // running mean + variance of average flow over the whole video
+    ofVec2f vidFlowAvg = ofVec2f(0,0); // store average flow of video
+    
+    SceneCutDetector cutDetector; // finds cuts so flow isn't calculated across them
+    FlowAccumulator shotFlowStats; // running stats of the current shot
+    ShotSummary currentShot;
+    float shotZoomTotal = 0;
+    bool bHasPrevFrame = false; // a frame of the current shot was seen, so this one's flow can be analyzed
+    vector<ShotSummary> shots; // summaries of all finished shots
+    vector<ShotSummary> prevShots; // shots of the last full pass, kept when the video loops
     
     // moving dot
     ofVec2f dotPos;
-    ofPolyline dotPath; // polyline tracks dot movement
+    DecimatedPath dotPath; // polyline tracks dot movement, older movement simplified
     
     
     // gui options - stolen from ofxCv example-flow
@@ -50,5 +79,7 @@ public:
     ofParameter<float> flowPyrScale, flowPolySigma, vidScale, lineWidth;
     ofParameter<int> flowLevels, flowIterations, flowPolyN, flowWinSize;
     ofParameter<bool> flowUseGaussian, loopVid;
+    ofParameter<bool> drawFlowStats; // draw motion histograms + region averages
+    ofParameter<bool> useRobustMotion; // move dot with fitted camera motion instead of plain average
 		
 };
@@ -0,0 +1,293 @@
+//
+//  FrameCache.cpp
+//  shared
+//
+
+#include "FrameCache.hpp"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+static const char cacheMagic[8] = {'F','R','M','C','A','C','H','E'};
+static const uint32_t cacheVersion = 2; // 2: frame range in the header
+static const int frameAlign = 64; // frames start on cache lines
+
+
+FrameCache::FrameCache(){
+}
+
+
+FrameCache::~FrameCache(){
+
+    close();
+}
+
+
+bool FrameCache::getSourceInfo(const string& path, uint64_t& size, int64_t& modified){
+
+    struct stat info;
+    if (stat(path.c_str(), &info) != 0) return false;
+
+    size = info.st_size;
+    modified = info.st_mtime;
+    return true;
+}
+
+
+//--------------------------------------------------------------
+// BUILD
+// one decode pass, frames written as they come. the header and index
+// are written last, into a temp file that's renamed when complete,
+// so a cache file is never half written
+//--------------------------------------------------------------
+
+bool FrameCache::build(const string& videoPath, const string& cachePath, float scale, int startFrame, int endFrame){
+
+    uint64_t startTime = ofGetElapsedTimeMillis();
+
+    string src = ofToDataPath(videoPath, true);
+    string dst = ofToDataPath(cachePath, true);
+    string tmp = dst + ".tmp";
+
+    VideoCapture capture(src);
+    if (!capture.isOpened()){
+        ofLogError("FrameCache") << "couldn't open " << src;
+        return false;
+    }
+
+    Header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, cacheMagic, sizeof(cacheMagic));
+    header.version = cacheVersion;
+    header.scale = scale > 0 ? scale : 1;
+    header.startFrame = max(startFrame, 0);
+    header.endFrame = endFrame < 0 ? -1 : endFrame;
+
+    if (!getSourceInfo(src, header.sourceSize, header.sourceModified)){
+        ofLogError("FrameCache") << "couldn't stat " << src;
+        return false;
+    }
+
+    ofFilePath::createEnclosingDirectory(dst);
+    ofstream out(tmp.c_str(), ios::binary);
+    if (!out){
+        ofLogError("FrameCache") << "couldn't write " << tmp;
+        return false;
+    }
+
+    uint64_t offset = (sizeof(Header) + frameAlign - 1) / frameAlign * frameAlign;
+    vector<char> padding(frameAlign, 0);
+    out.write(padding.data(), offset); // header goes here at the end
+
+    // decode up to startFrame instead of seeking there, so the source frame #s in the index are exact
+    // (a CV_CAP_PROP_POS_FRAMES seek can be a few frames off with ffmpeg on MP4). only paid once per cache
+
+    int f = 0;
+    while (f < header.startFrame && capture.grab()) f++;
+
+    vector<IndexEntry> index;
+    Mat frame, gray, scaled;
+
+    for (; header.endFrame < 0 || f < header.endFrame; f++){
+
+        if (!capture.read(frame)) break;
+
+        cvtColor(frame, gray, CV_BGR2GRAY);
+
+        Mat* result = &gray;
+        if (header.scale != 1){
+            resize(gray, scaled, cv::Size(), header.scale, header.scale, INTER_AREA);
+            result = &scaled;
+        }
+
+        if (index.empty()){
+            header.width = result->cols;
+            header.height = result->rows;
+            header.frameBytes = (header.width * header.height + frameAlign - 1) / frameAlign * frameAlign;
+        }
+
+        for (int y=0; y<result->rows; y++){
+            out.write((const char*)result->ptr(y), result->cols);
+        }
+        out.write(padding.data(), header.frameBytes - header.width * header.height);
+
+        IndexEntry entry;
+        entry.offset = offset;
+        entry.sourceFrame = f;
+        entry.reserved = 0;
+        index.push_back(entry);
+
+        offset += header.frameBytes;
+    }
+
+    header.nFrames = index.size();
+    header.indexOffset = offset;
+
+    out.write((const char*)index.data(), index.size() * sizeof(IndexEntry));
+    out.seekp(0);
+    out.write((const char*)&header, sizeof(header));
+    out.close();
+
+    if (!out || index.empty() || std::rename(tmp.c_str(), dst.c_str()) != 0){
+        ofLogError("FrameCache") << "couldn't build " << dst << (index.empty() ? " (no frames decoded)" : "");
+        std::remove(tmp.c_str());
+        return false;
+    }
+
+    ofLogNotice("FrameCache") << "cached " << index.size() << " frames of " << videoPath << " at " << header.width << "x" << header.height
+    << " (" << (offset + index.size() * sizeof(IndexEntry)) / (1024 * 1024) << " MB) in " << ofGetElapsedTimeMillis() - startTime << " ms";
+
+    return true;
+}
+
+
+//--------------------------------------------------------------
+// OPEN
+//--------------------------------------------------------------
+
+bool FrameCache::open(const string& cachePath){
+
+    close();
+
+    string path = ofToDataPath(cachePath, true);
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size < (off_t)sizeof(Header)){
+        ::close(fd);
+        return false;
+    }
+
+    void* mapped = mmap(nullptr, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd); // the mapping keeps the file open
+
+    if (mapped == MAP_FAILED){
+        ofLogError("FrameCache") << "couldn't map " << path;
+        return false;
+    }
+
+    data = (unsigned char*)mapped;
+    dataSize = info.st_size;
+    header = (const Header*)data;
+
+    // check it's a complete cache file of this version before trusting any offsets in it
+
+    bool bValid = memcmp(header->magic, cacheMagic, sizeof(cacheMagic)) == 0
+        && header->version == cacheVersion
+        && header->frameBytes >= (uint64_t)header->width * header->height
+        && header->indexOffset % alignof(IndexEntry) == 0
+        && header->indexOffset <= dataSize
+        && header->nFrames * sizeof(IndexEntry) <= dataSize - header->indexOffset
+        && header->indexOffset >= (uint64_t)header->nFrames * header->frameBytes;
+
+    index = bValid ? (const IndexEntry*)(data + header->indexOffset) : nullptr;
+
+    // and every frame inside the file, getFrame() hands out Mats on them unchecked
+
+    for (uint32_t i=0; bValid && i<header->nFrames; i++){
+        bValid = index[i].offset <= dataSize && header->frameBytes <= dataSize - index[i].offset;
+    }
+
+    if (!bValid){
+        ofLogError("FrameCache") << path << " isn't a frame cache (or from another version, or damaged)";
+        close();
+        return false;
+    }
+
+    madvise(data, dataSize, MADV_SEQUENTIAL); // analysis reads frames in order, read ahead
+
+    return true;
+}
+
+
+bool FrameCache::openOrBuild(const string& videoPath, const string& cachePath, float scale, int startFrame, int endFrame){
+
+    uint64_t size;
+    int64_t modified;
+
+    if (!getSourceInfo(ofToDataPath(videoPath, true), size, modified)){
+        ofLogError("FrameCache") << "couldn't find " << videoPath;
+        return false;
+    }
+
+    scale = scale > 0 ? scale : 1; // as build() stores them
+    startFrame = max(startFrame, 0);
+    endFrame = endFrame < 0 ? -1 : endFrame;
+
+    if (open(cachePath) && header->sourceSize == size && header->sourceModified == modified && header->scale == scale
+        && header->startFrame == startFrame && header->endFrame == endFrame){
+        return true; // up to date
+    }
+
+    close();
+
+    return build(videoPath, cachePath, scale, startFrame, endFrame) && open(cachePath);
+}
+
+
+void FrameCache::close(){
+
+    if (data){
+        munmap(data, dataSize);
+    }
+
+    data = nullptr;
+    dataSize = 0;
+    header = nullptr;
+    index = nullptr;
+}
+
+
+//--------------------------------------------------------------
+// FRAMES
+//--------------------------------------------------------------
+
+bool FrameCache::isOpen() const{
+
+    return data != nullptr;
+}
+
+
+int FrameCache::getNumFrames() const{
+
+    return header ? header->nFrames : 0;
+}
+
+
+int FrameCache::getWidth() const{
+
+    return header ? header->width : 0;
+}
+
+
+int FrameCache::getHeight() const{
+
+    return header ? header->height : 0;
+}
+
+
+float FrameCache::getScale() const{
+
+    return header ? header->scale : 1;
+}
+
+
+Mat FrameCache::getFrame(int i) const{
+
+    if (!header || i < 0 || i >= (int)header->nFrames) return Mat();
+
+    // the mapping is read only, the const_cast is never written through
+    return Mat(header->height, header->width, CV_8UC1, const_cast<unsigned char*>(data + index[i].offset));
+}
+
+
+int FrameCache::getSourceFrame(int i) const{
+
+    if (!header || i < 0 || i >= (int)header->nFrames) return -1;
+
+    return index[i].sourceFrame;
+}
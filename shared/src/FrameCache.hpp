@@ -0,0 +1,85 @@
+//
+//  FrameCache.hpp
+//  shared
+//
+
+#pragma once
+#include "ofMain.h"
+#include "ofxOpenCv.h"
+#include "ofxCv.h"
+
+using namespace cv;
+using namespace ofxCv;
+
+
+// decoded video frames on disk, for analysis runs over the same clip again and again
+// (tweaking flow parameters, histogram settings...):
+//   - build() decodes a clip once, into grayscale (optionally downscaled) frames in one file
+//   - open() memory-maps that file, getFrame() is then a Mat header on the mapped pages:
+//     no codec, no copy, the OS pages frames in (and keeps them cached between runs)
+//
+// file layout: header | frames (each padded to 64 bytes) | index (offset + source frame # per frame).
+// the header keeps the source's size + modification time and the frame range,
+// openOrBuild() rebuilds when the clip changed or a different range is asked for.
+// frames are read only, writing into a Mat from getFrame() crashes
+//
+// mapping is POSIX mmap (macOS, Linux)
+
+class FrameCache {
+
+public:
+
+    FrameCache();
+    ~FrameCache(); // unmaps
+    FrameCache(const FrameCache&) = delete; // a copy would unmap the same pages again
+    FrameCache& operator=(const FrameCache&) = delete;
+
+    static bool build(const string& videoPath, const string& cachePath, float scale = 1, int startFrame = 0, int endFrame = -1);
+    // decodes frames startFrame to endFrame (exclusive, -1 = to the end) of videoPath (cv::VideoCapture),
+    // scale < 1 downscales them. paths relative to bin/data or absolute.
+    // frames before startFrame are decoded and dropped, seeking isn't frame-accurate with every codec
+
+    bool open(const string& cachePath);
+    bool openOrBuild(const string& videoPath, const string& cachePath, float scale = 1, int startFrame = 0, int endFrame = -1);
+    // opens cachePath if it was built from videoPath as it is now, at this scale and with this range,
+    // builds it first otherwise
+    void close();
+
+    bool isOpen() const;
+    int getNumFrames() const;
+    int getWidth() const;
+    int getHeight() const;
+    float getScale() const;
+
+    Mat getFrame(int i) const; // CV_8UC1 on the mapped file
+    int getSourceFrame(int i) const; // frame # in the source video
+
+private:
+
+    struct Header {
+        char magic[8]; // "FRMCACHE"
+        uint32_t version;
+        uint32_t width, height;
+        uint32_t nFrames;
+        float scale;
+        uint32_t frameBytes; // width * height, padded to 64
+        uint64_t indexOffset;
+        uint64_t sourceSize; // bytes
+        int64_t sourceModified; // seconds since epoch
+        int32_t startFrame, endFrame; // the range build() was asked for (endFrame -1 = to the end)
+    };
+
+    struct IndexEntry {
+        uint64_t offset; // from the start of the file
+        int32_t sourceFrame;
+        int32_t reserved;
+    };
+
+    static bool getSourceInfo(const string& path, uint64_t& size, int64_t& modified);
+
+    unsigned char* data = nullptr;
+    size_t dataSize = 0;
+    const Header* header = nullptr;
+    const IndexEntry* index = nullptr;
+
+};
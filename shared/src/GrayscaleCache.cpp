@@ -0,0 +1,79 @@
+//
+//  GrayscaleCache.cpp
+//  shared
+//
+
+#include "GrayscaleCache.hpp"
+
+
+GrayscaleCache::GrayscaleCache(){
+}
+
+
+const Mat& GrayscaleCache::get(const ofPixels& src, uint64_t generation){
+
+    if (!src.isAllocated()){
+        result = Mat();
+        bValid = false;
+        return result;
+    }
+
+    // toCv() only wraps the pixels, the const_cast is never written through
+
+    return get(toCv(const_cast<ofPixels&>(src)), generation);
+}
+
+
+const Mat& GrayscaleCache::get(const Mat& src, uint64_t generation){
+
+    if (bValid && src.data == srcData && src.cols == srcWidth && src.rows == srcHeight
+        && src.channels() == srcChannels && generation == srcGeneration){
+        return result; // same pixels as last time
+    }
+
+    srcData = src.data;
+    srcWidth = src.cols;
+    srcHeight = src.rows;
+    srcChannels = src.channels();
+    srcGeneration = generation;
+    bValid = true;
+
+    switch (srcChannels){
+
+        case 1:
+            result = src; // already grayscale: just wrap it
+            break;
+
+        case 3:
+            cvtColor(src, gray, CV_RGB2GRAY); // gray is reused while the size stays the same
+            result = gray;
+            nConversions++;
+            break;
+
+        case 4:
+            cvtColor(src, gray, CV_RGBA2GRAY);
+            result = gray;
+            nConversions++;
+            break;
+
+        default:
+            ofLogError("GrayscaleCache") << "can't convert " << srcChannels << " channel image to grayscale";
+            result = Mat();
+            bValid = false;
+    }
+
+    return result;
+}
+
+
+const Mat& GrayscaleCache::get() const{
+    return result;
+}
+
+void GrayscaleCache::invalidate(){
+    bValid = false;
+}
+
+int GrayscaleCache::getConversions() const{
+    return nConversions;
+}
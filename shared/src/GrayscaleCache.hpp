@@ -0,0 +1,51 @@
+//
+//  GrayscaleCache.hpp
+//  shared
+//
+
+#pragma once
+#include "ofMain.h"
+#include "ofxOpenCv.h"
+#include "ofxCv.h"
+
+using namespace cv;
+using namespace ofxCv;
+
+
+// grayscale Mat of an image for the CV code, without touching the source
+// (no setImageType(), so the caller's ofImage keeps its colors and its GPU texture isn't re-uploaded):
+//   - single-channel sources are wrapped as they are, no conversion and no copy
+//   - color sources are converted into a buffer owned by the cache
+//
+// the result is cached, keyed on the source's identity (pixel data pointer, size, channels)
+// and a generation number from the caller. the same pixels + generation returns the cached Mat,
+// so bump the generation whenever the pixels change in place (new video frame, reloaded image)
+
+class GrayscaleCache {
+
+public:
+
+    GrayscaleCache();
+
+    const Mat& get(const ofPixels& src, uint64_t generation = 0);
+    const Mat& get(const Mat& src, uint64_t generation = 0);
+    // color Mats are taken to be in oF's channel order (RGB / RGBA), as from toCv()
+
+    const Mat& get() const; // last result
+
+    void invalidate(); // next get() converts again
+
+    int getConversions() const; // # of actual color -> gray conversions so far (the rest were cache hits)
+
+private:
+
+    const uchar* srcData = nullptr;
+    int srcWidth = 0, srcHeight = 0, srcChannels = 0;
+    uint64_t srcGeneration = 0;
+    bool bValid = false;
+
+    Mat gray; // converted pixels, owned
+    Mat result; // gray, or a wrapper around a single-channel source
+    int nConversions = 0;
+
+};
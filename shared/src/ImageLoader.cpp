@@ -0,0 +1,167 @@
+//
+//  ImageLoader.cpp
+//  shared
+//
+
+#include "ImageLoader.hpp"
+
+
+ImageLoader::ImageLoader(){
+}
+
+
+ImageLoader::~ImageLoader(){
+
+    stop();
+}
+
+
+void ImageLoader::setup(int _nThreads, int _queueSize, bool _bGrayscale){
+
+    stop();
+
+    nThreads = max(_nThreads, 1);
+    queueSize = max(_queueSize, 1);
+    bGrayscale = _bGrayscale;
+}
+
+
+void ImageLoader::start(const vector<string>& _paths){
+
+    stop();
+
+    paths.clear();
+    for (auto& path : _paths){
+        paths.push_back(ofToDataPath(path, true)); // ofToDataPath isn't safe to call from the workers
+    }
+
+    nextDecode = 0;
+    nextOut = 0;
+    ready.clear();
+    bStopping = false;
+    waitMicros = 0;
+
+    int n = min(nThreads, (int)paths.size());
+    for (int i=0; i<n; i++){
+        workers.push_back(std::thread(&ImageLoader::work, this));
+    }
+}
+
+
+bool ImageLoader::next(Item& item){
+
+    std::unique_lock<std::mutex> lock(mutex);
+
+    if (nextOut >= paths.size() || bStopping) return false;
+
+    uint64_t start = ofGetElapsedTimeMicros();
+    readyCond.wait(lock, [&]{ return bStopping || ready.count(nextOut); });
+    waitMicros += ofGetElapsedTimeMicros() - start;
+
+    if (bStopping) return false;
+
+    auto it = ready.find(nextOut);
+    item = std::move(it->second);
+    ready.erase(it);
+    nextOut++;
+
+    lock.unlock();
+    spaceCond.notify_all(); // one more image can be decoded ahead
+
+    return true;
+}
+
+
+void ImageLoader::stop(){
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        bStopping = true;
+    }
+    readyCond.notify_all();
+    spaceCond.notify_all();
+
+    for (auto& worker : workers){
+        worker.join();
+    }
+    workers.clear();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    ready.clear();
+}
+
+
+int ImageLoader::getNumImages() const{
+
+    return paths.size();
+}
+
+
+int ImageLoader::getNumReady(){
+
+    std::lock_guard<std::mutex> lock(mutex);
+    return ready.size();
+}
+
+
+uint64_t ImageLoader::getWaitMicros() const{
+
+    return waitMicros;
+}
+
+
+//--------------------------------------------------------------
+// WORKER
+// takes the next path as soon as it's less than queueSize images
+// ahead of the caller, decodes it without holding the lock
+//--------------------------------------------------------------
+
+void ImageLoader::work(){
+
+    while (true){
+
+        Item item;
+
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+
+            spaceCond.wait(lock, [&]{ return bStopping || nextDecode >= paths.size() || nextDecode - nextOut < queueSize; });
+
+            if (bStopping || nextDecode >= paths.size()) return;
+
+            item.index = nextDecode++;
+            item.path = paths[item.index];
+        }
+
+        uint64_t start = ofGetElapsedTimeMicros();
+        decode(item);
+        item.decodeMicros = ofGetElapsedTimeMicros() - start;
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (bStopping) return;
+            ready[item.index] = std::move(item);
+        }
+        readyCond.notify_all();
+    }
+}
+
+
+bool ImageLoader::decode(Item& item){
+
+    // imread, not ofImage: no texture / GL, and grayscale comes straight from the decoder
+    // (for JPEGs that's the luma plane, no color conversion at all)
+
+    if (bGrayscale){
+        item.mat = imread(item.path, CV_LOAD_IMAGE_GRAYSCALE);
+    } else {
+        item.mat = imread(item.path, CV_LOAD_IMAGE_COLOR);
+        if (!item.mat.empty()) cvtColor(item.mat, item.mat, CV_BGR2RGB); // oF channel order, like toCv()
+    }
+
+    if (item.mat.empty()){
+        ofLogError("ImageLoader") << "couldn't load " << item.path;
+        return false;
+    }
+    return true;
+}
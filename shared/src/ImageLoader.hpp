@@ -0,0 +1,84 @@
+//
+//  ImageLoader.hpp
+//  shared
+//
+
+#pragma once
+#include "ofMain.h"
+#include "ofxOpenCv.h"
+#include "ofxCv.h"
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+using namespace cv;
+using namespace ofxCv;
+
+
+// prefetching image loader for batch jobs: worker threads decode a list of images
+// (JPEG decode + grayscale conversion, no GL) while the caller works on the previous ones,
+// so a batch takes about max(decode, match) per image instead of decode + match.
+//
+//   loader.setup(2, 4); // 2 decode threads, at most 4 images decoded ahead
+//   loader.start(paths);
+//   ImageLoader::Item item;
+//   while (loader.next(item)){ ... item.mat ... }
+//
+// images come out of next() in the order of paths. workers stop decoding once they are
+// queueSize images ahead of the caller (backpressure), so memory stays bounded for any list length
+
+class ImageLoader {
+
+public:
+
+    struct Item {
+        int index = -1; // into the paths given to start()
+        string path;
+        Mat mat; // grayscale, or RGB (oF channel order) if setup() asked for color. empty if it couldn't be loaded
+        uint64_t decodeMicros = 0; // time the worker spent on this image
+    };
+
+    ImageLoader();
+    ~ImageLoader(); // stops the workers
+
+    void setup(int _nThreads = 2, int _queueSize = 4, bool _bGrayscale = true);
+
+    void start(const vector<string>& _paths);
+    // starts decoding paths (relative to bin/data, or absolute) in the background,
+    // stops a previous batch if there is one
+
+    bool next(Item& item);
+    // waits for the next image in order, false once all of them were returned (or after stop())
+
+    void stop(); // drops queued images, joins the workers
+
+    int getNumImages() const;
+    int getNumReady(); // decoded and waiting for next()
+    uint64_t getWaitMicros() const; // total time next() spent waiting on workers (0 = decoding kept up)
+
+private:
+
+    void work();
+    bool decode(Item& item);
+
+    int nThreads = 2;
+    int queueSize = 4;
+    bool bGrayscale = true;
+
+    vector<string> paths;
+    vector<std::thread> workers;
+
+    std::mutex mutex;
+    std::condition_variable readyCond; // a decoded image was added (next() waits on it)
+    std::condition_variable spaceCond; // next() took an image (workers wait on it for space)
+
+    // all guarded by mutex
+    int nextDecode = 0; // next path a worker takes
+    int nextOut = 0; // next index next() returns
+    map<int, Item> ready; // decoded, by index (workers can finish out of order)
+    bool bStopping = false;
+
+    uint64_t waitMicros = 0;
+
+};
@@ -0,0 +1,365 @@
+//
+//  TaskScheduler.cpp
+//  shared
+//
+
+#include "TaskScheduler.hpp"
+
+
+static int numCores(){
+
+    return max((int)std::thread::hardware_concurrency(), 1); // 0 if unknown
+}
+
+
+TaskScheduler& TaskScheduler::get(){
+
+    static TaskScheduler scheduler; // started on first use, thread-safe since C++11
+    return scheduler;
+}
+
+
+TaskScheduler::TaskScheduler(){
+
+    // setup()'s thread default, but OpenCV's pool is left as it is:
+    // capping it is process-wide, so only an explicit setup() does that
+
+    nQueued = 0;
+    nThreads = numCores();
+    nOpenCvThreads = cv::getNumThreads();
+
+    start();
+}
+
+
+TaskScheduler::~TaskScheduler(){
+
+    stop();
+}
+
+
+void TaskScheduler::setup(int _nThreads, int _nOpenCvThreads){
+
+    stop();
+
+    nThreads = _nThreads > 0 ? _nThreads : numCores();
+    nOpenCvThreads = _nOpenCvThreads > 0 ? _nOpenCvThreads : max(numCores() - nThreads, 1);
+
+    cv::setNumThreads(nOpenCvThreads);
+
+    start();
+
+    ofLogNotice("TaskScheduler") << nThreads << " threads, OpenCV capped to " << nOpenCvThreads;
+}
+
+
+int TaskScheduler::getNumThreads() const{
+
+    return nThreads;
+}
+
+
+int TaskScheduler::getNumOpenCvThreads() const{
+
+    return nOpenCvThreads;
+}
+
+
+//--------------------------------------------------------------
+// WORKERS
+//--------------------------------------------------------------
+
+void TaskScheduler::start(){
+
+    // the calling thread counts as one of nThreads (it works while waiting on a group),
+    // so nThreads - 1 workers
+
+    int nWorkers = nThreads - 1;
+
+    queues.clear();
+    for (int i=0; i<nWorkers + 1; i++){ // + the queue for other threads
+        queues.push_back(unique_ptr<Queue>(new Queue()));
+        queues.back()->tasks.resize(queueCapacity); // all the allocation the queues do
+    }
+
+    bStopping = false;
+    nQueued = 0;
+
+    // workers wait for sleepMutex before they start, so workerIds is complete before any of them reads it
+
+    std::lock_guard<std::mutex> lock(sleepMutex);
+
+    for (int i=0; i<nWorkers; i++){
+        workers.push_back(std::thread(&TaskScheduler::work, this));
+        workerIds.push_back(workers.back().get_id());
+    }
+}
+
+
+void TaskScheduler::stop(){
+
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        bStopping = true;
+    }
+    wake.notify_all();
+
+    for (auto& worker : workers){
+        worker.join();
+    }
+    workers.clear();
+    workerIds.clear();
+}
+
+
+void TaskScheduler::work(){
+
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex); // until start() is done
+    }
+
+    while (true){
+
+        if (runOne()) continue;
+
+        // nothing to run or steal: sleep until a task is pushed
+        // (nQueued is raised under sleepMutex, so a push can't slip in between the check and the wait)
+
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        wake.wait(lock, [&]{ return bStopping || nQueued > 0; });
+        if (bStopping) return;
+    }
+}
+
+
+int TaskScheduler::currentQueue() const{
+
+    std::thread::id id = std::this_thread::get_id();
+
+    for (int i=0; i<workerIds.size(); i++){ // a handful of threads, a linear search is fine
+        if (workerIds[i] == id) return i;
+    }
+    return queues.size() - 1;
+}
+
+
+void TaskScheduler::push(Task&& task){
+
+    Queue& queue = *queues[currentQueue()];
+    bool bFull = false;
+
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+
+        if (queue.size == queueCapacity){
+            bFull = true;
+        } else {
+            queue.tasks[(queue.head + queue.size) % queueCapacity] = std::move(task);
+            queue.size++;
+        }
+    }
+
+    if (bFull){ // thousands of tasks waiting already, this one won't be missed by the other threads
+        execute(task);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        nQueued++;
+    }
+    wake.notify_one();
+}
+
+
+bool TaskScheduler::pop(int queueIndex, bool bNewest, TaskGroup* group, Task& task){
+
+    Queue& queue = *queues[queueIndex];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+
+    // newest or oldest task (of group, if there is one). without a group that's the first one looked at,
+    // with one the queue is searched, it only holds a handful of tasks
+
+    for (int k=0; k<queue.size; k++){
+
+        int pos = bNewest ? queue.size - 1 - k : k;
+        Task& slot = queue.tasks[(queue.head + pos) % queueCapacity];
+
+        if (group && slot.group != group) continue;
+
+        task = std::move(slot);
+
+        if (pos == 0){
+            slot.fn = nullptr; // drop what the moved-from function may still hold
+            queue.head = (queue.head + 1) % queueCapacity;
+        } else {
+            // close the gap: the newer tasks move down one slot
+            for (int p=pos; p<queue.size - 1; p++){
+                queue.tasks[(queue.head + p) % queueCapacity] = std::move(queue.tasks[(queue.head + p + 1) % queueCapacity]);
+            }
+            queue.tasks[(queue.head + queue.size - 1) % queueCapacity].fn = nullptr;
+        }
+
+        queue.size--;
+        nQueued--;
+        return true;
+    }
+
+    return false;
+}
+
+
+bool TaskScheduler::runOne(TaskGroup* group){
+
+    if (nQueued <= 0) return false;
+
+    int self = currentQueue();
+    int n = queues.size();
+
+    // own tasks newest first, then steal the oldest from the others, starting next to self
+    // so thieves spread over the queues
+
+    Task task;
+    bool bFound = pop(self, true, group, task);
+
+    for (int i=1; i<n && !bFound; i++){
+        bFound = pop((self + i) % n, false, group, task);
+    }
+
+    if (!bFound) return false;
+
+    execute(task);
+    return true;
+}
+
+
+void TaskScheduler::execute(Task& task){
+
+    std::exception_ptr error;
+    try {
+        task.fn();
+    } catch (...) {
+        error = std::current_exception();
+    }
+    task.group->finished(error);
+}
+
+
+//--------------------------------------------------------------
+// PARALLEL FOR
+//--------------------------------------------------------------
+
+void TaskScheduler::parallelFor(int begin, int end, int grain, const function<void(int, int)>& fn){
+
+    int n = end - begin;
+    if (n <= 0) return;
+
+    // ~4 chunks per thread, so threads that finish early can steal,
+    // but never smaller than grain (the caller knows how much work one index is)
+
+    int chunk = max(grain, (n + nThreads * 4 - 1) / (nThreads * 4));
+
+    if (nThreads == 1 || chunk >= n){
+        fn(begin, end);
+        return;
+    }
+
+    TaskGroup group(*this);
+
+    for (int i=begin + chunk; i<end; i+=chunk){
+        int chunkEnd = min(i + chunk, end);
+        group.run([&fn, i, chunkEnd]{ fn(i, chunkEnd); });
+    }
+
+    fn(begin, min(begin + chunk, end)); // first chunk on this thread, the rest get stolen meanwhile
+
+    group.wait();
+}
+
+
+//--------------------------------------------------------------
+// TASK GROUP
+//--------------------------------------------------------------
+
+TaskGroup::TaskGroup(TaskScheduler& _scheduler) : scheduler(_scheduler){
+
+    nRemaining = 0;
+}
+
+
+TaskGroup::~TaskGroup(){
+
+    // tasks reference the group, it can't go away before they're done
+    // (an error is dropped here, call wait() to get it)
+
+    waitForTasks();
+}
+
+
+void TaskGroup::run(const function<void()>& fn){
+
+    nRemaining++;
+
+    TaskScheduler::Task task;
+    task.fn = fn;
+    task.group = this;
+
+    scheduler.push(std::move(task));
+}
+
+
+void TaskGroup::wait(){
+
+    waitForTasks();
+
+    std::exception_ptr e;
+    {
+        std::lock_guard<std::mutex> lock(errorMutex);
+        e = error;
+        error = nullptr;
+    }
+    if (e) std::rethrow_exception(e);
+}
+
+
+void TaskGroup::waitForTasks(){
+
+    // help out instead of blocking: run our own queued tasks until they're all done.
+    // not other groups' tasks: one of those could take much longer than what's left of ours
+    // (another FlowBatch segment while waiting on a parallelFor inside one), holding up our caller.
+    //
+    // once none of ours are queued the rest are running on other threads. short ones are done in a
+    // few yields, for long ones (a FlowBatch segment, a FlowSweep frame) the thread sleeps until the
+    // last one signals, instead of spinning a core. it wakes every ms to look for tasks of ours
+    // queued meanwhile (a task can add more to its own group)
+
+    int nIdle = 0;
+
+    while (nRemaining > 0){
+
+        if (scheduler.runOne(this)){
+            nIdle = 0;
+        } else if (++nIdle < 64){
+            std::this_thread::yield();
+        } else {
+            std::unique_lock<std::mutex> lock(doneMutex);
+            done.wait_for(lock, std::chrono::milliseconds(1), [&]{ return nRemaining == 0; });
+        }
+    }
+
+    // the last finished() may still hold doneMutex, the group can only go away once it let go
+    std::lock_guard<std::mutex> lock(doneMutex);
+}
+
+
+void TaskGroup::finished(std::exception_ptr _error){
+
+    if (_error){
+        std::lock_guard<std::mutex> lock(errorMutex);
+        if (!error) error = _error;
+    }
+
+    // under doneMutex, so a waiter can't see 0, return and destroy the group before the notify
+    std::lock_guard<std::mutex> lock(doneMutex);
+    if (--nRemaining == 0) done.notify_all();
+}
@@ -0,0 +1,136 @@
+//
+//  TaskScheduler.hpp
+//  shared
+//
+
+#pragma once
+#include "ofMain.h"
+#include "ofxOpenCv.h"
+#include "ofxCv.h"
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+using namespace cv;
+using namespace ofxCv;
+
+
+// work-stealing task scheduler shared by all of the engines (one per process, TaskScheduler::get()):
+//   - every worker thread has its own deque of tasks. it runs its newest task first (still in cache),
+//     and when it runs out it steals the oldest task of another worker (usually the biggest piece left)
+//   - tasks are grouped in TaskGroups: wait() runs its group's own queued tasks until none are left,
+//     so groups can be nested (parallelFor inside a task) without deadlocking. only its own: a thread
+//     waiting inside a task never picks up an unrelated (maybe long) one. then it sleeps until the
+//     tasks still running on other threads are done, rather than spinning
+//   - parallelFor() splits an index range into chunks, the calling thread works on them too
+//   - the deques are fixed-size rings allocated when the workers start, so submitting a task doesn't
+//     allocate (a task whose queue is full runs right away on the submitting thread)
+//
+// OpenCV has its own thread pool (GCD / TBB / pthreads) under functions like cvtColor or resize.
+// both at full size oversubscribe the machine, so setup() also caps OpenCV's threads (cv::setNumThreads).
+// by default the scheduler gets every core and OpenCV gets 1 thread: parallelism comes from our tasks.
+// the cap is only set by an explicit setup(), a scheduler started on first use leaves OpenCV alone
+
+class TaskGroup;
+
+class TaskScheduler {
+
+public:
+
+    static TaskScheduler& get();
+    // the project-wide scheduler, started with one thread per core on first use (OpenCV's threads untouched)
+
+    ~TaskScheduler(); // stops + joins the workers
+
+    void setup(int nThreads = 0, int nOpenCvThreads = -1);
+    // nThreads: threads working on tasks, including the calling thread (0 = one per core)
+    // nOpenCvThreads: cap for OpenCV's own pool (-1 = the cores the scheduler leaves over, at least 1)
+    // restarts the workers, call it before submitting anything (i.e. in ofApp::setup())
+
+    int getNumThreads() const;
+    int getNumOpenCvThreads() const; // OpenCV's own count if setup() hasn't capped it
+
+    void parallelFor(int begin, int end, int grain, const function<void(int, int)>& fn);
+    // calls fn(chunkBegin, chunkEnd) for chunks of [begin, end) of at least grain indices, in parallel.
+    // returns when all of them are done
+
+private:
+
+    friend class TaskGroup;
+
+    TaskScheduler();
+
+    struct Task {
+        function<void()> fn;
+        TaskGroup* group = nullptr;
+    };
+
+    static const int queueCapacity = 1024;
+
+    struct Queue {
+        vector<Task> tasks; // ring of queueCapacity slots
+        int head = 0, size = 0; // oldest task, # of queued tasks
+        std::mutex mutex;
+    };
+
+    void start();
+    void stop();
+
+    void push(Task&& task);
+    bool runOne(TaskGroup* group = nullptr);
+    // runs one queued task from this thread's deque or a stolen one, false if there was none.
+    // with a group, only that group's tasks
+    bool pop(int queue, bool bNewest, TaskGroup* group, Task& task);
+    void execute(Task& task); // runs it and tells its group
+    int currentQueue() const; // this thread's queue, the shared one for threads that aren't workers
+    void work();
+
+    int nThreads = 1, nOpenCvThreads = 1;
+
+    vector<std::thread> workers;
+    vector<std::thread::id> workerIds;
+    vector<unique_ptr<Queue>> queues; // one per worker + one for tasks from other threads (last)
+
+    std::mutex sleepMutex;
+    std::condition_variable wake;
+    std::atomic<int> nQueued;
+    bool bStopping = false;
+
+};
+
+
+// tasks that can be waited on together:
+//   TaskGroup group;
+//   group.run([&]{ ... });
+//   group.run([&]{ ... });
+//   group.wait(); // also runs tasks itself until both are done
+//
+// an exception thrown by a task is passed on by wait() (the first one, the rest are dropped)
+
+class TaskGroup {
+
+public:
+
+    TaskGroup(TaskScheduler& _scheduler = TaskScheduler::get());
+    ~TaskGroup(); // waits
+
+    void run(const function<void()>& fn);
+    void wait();
+
+private:
+
+    friend class TaskScheduler;
+
+    void waitForTasks(); // runs our queued tasks, then sleeps until the ones on other threads are done
+    void finished(std::exception_ptr error);
+
+    TaskScheduler& scheduler;
+    std::atomic<int> nRemaining;
+    std::mutex errorMutex;
+    std::exception_ptr error;
+    std::mutex doneMutex;
+    std::condition_variable done; // signaled by the last task to finish
+
+};
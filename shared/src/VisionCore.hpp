@@ -0,0 +1,33 @@
+//
+//  VisionCore.hpp
+//  shared
+//
+
+#pragma once
+
+// all of the engines in shared/src, for tools linking libvisioncore.a (see shared/Makefile).
+// every engine has cv::Mat entry points and none of them need an ofApp or a window,
+// only oF's core (logging, ofPixels / ofVec2f types) + OpenCV through ofxCv
+
+#include "GrayscaleCache.hpp"
+#include "ImageLoader.hpp"
+#include "FrameCache.hpp"
+#include "TaskScheduler.hpp"
+
+// sift
+#include "SIFTMatcher.hpp"
+#include "SIFTTracker.hpp"
+#include "MultiMatcher.hpp"
+
+// histogrid
+#include "Histogrid.hpp"
+
+// flow
+#include "FlowMotionEstimator.hpp"
+#include "FlowStats.hpp"
+#include "FlowDescriptor.hpp"
+#include "FlowAccumulator.hpp"
+#include "SceneCutDetector.hpp"
+#include "FlowSettings.hpp"
+#include "FlowBatch.hpp"
+#include "FlowSweep.hpp"
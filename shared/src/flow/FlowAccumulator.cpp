@@ -0,0 +1,60 @@
+//
+//  FlowAccumulator.cpp
+//  optFlowTest
+//
+
+#include "FlowAccumulator.hpp"
+
+
+FlowAccumulator::FlowAccumulator(){
+}
+
+void FlowAccumulator::add(const Point2f& v){
+
+    count++;
+
+    double dx = v.x - meanX;
+    double dy = v.y - meanY;
+
+    meanX += dx / count;
+    meanY += dy / count;
+
+    m2X += dx * (v.x - meanX); // uses the updated mean
+    m2Y += dy * (v.y - meanY);
+
+    magTotal += sqrt(v.x*v.x + v.y*v.y);
+}
+
+void FlowAccumulator::clear(){
+
+    count = 0;
+    meanX = meanY = 0;
+    m2X = m2Y = 0;
+    magTotal = 0;
+}
+
+int FlowAccumulator::getCount() const{
+    return count;
+}
+
+Point2f FlowAccumulator::getMean() const{
+    return Point2f(meanX, meanY);
+}
+
+Point2f FlowAccumulator::getVariance() const{
+
+    if (count < 2) return Point2f(0,0);
+    return Point2f(m2X / count, m2Y / count);
+}
+
+Point2f FlowAccumulator::getStdDev() const{
+
+    Point2f var = getVariance();
+    return Point2f(sqrtf(var.x), sqrtf(var.y));
+}
+
+float FlowAccumulator::getMeanMagnitude() const{
+
+    if (count == 0) return 0;
+    return magTotal / count;
+}
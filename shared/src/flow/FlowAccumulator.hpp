@@ -0,0 +1,83 @@
+//
+//  FlowAccumulator.hpp
+//  optFlowTest
+//
+
+#pragma once
+#include "ofMain.h"
+
+#include "ofxOpenCv.h"
+#include "ofxCv.h"
+
+using namespace cv;
+using namespace ofxCv;
+
+
+// fixed capacity buffer that keeps the most recent values
+// index 0 is the oldest kept value, back() the newest
+
+template <class T>
+class RingBuffer {
+
+public:
+
+    RingBuffer(int _capacity = 0){
+        setCapacity(_capacity);
+    }
+
+    void setCapacity(int _capacity){
+        buffer.assign(max(1, _capacity), T());
+        clear();
+    }
+
+    void push_back(const T& value){
+        buffer[(start + count) % buffer.size()] = value;
+        if (count < buffer.size()){
+            count++;
+        } else {
+            start = (start + 1) % buffer.size(); // full: overwrite oldest
+        }
+    }
+
+    const T& operator[](int i) const { return buffer[(start + i) % buffer.size()]; }
+    const T& back() const { return (*this)[count - 1]; }
+
+    int size() const { return count; }
+    int capacity() const { return buffer.size(); }
+    bool empty() const { return count == 0; }
+    void clear() { start = 0; count = 0; }
+
+private:
+
+    vector<T> buffer;
+    int start = 0, count = 0;
+
+};
+
+
+// running mean + variance of a 2D value (Welford's algorithm)
+// constant memory no matter how many frames are added
+
+class FlowAccumulator {
+
+public:
+
+    FlowAccumulator();
+
+    void add(const Point2f& v);
+    void clear();
+
+    int getCount() const;
+    Point2f getMean() const;
+    Point2f getVariance() const; // per axis, population variance
+    Point2f getStdDev() const;
+    float getMeanMagnitude() const; // mean of |v|, not |mean|
+
+private:
+
+    int count = 0;
+    double meanX = 0, meanY = 0;
+    double m2X = 0, m2Y = 0; // sums of squared differences from the mean
+    double magTotal = 0;
+
+};
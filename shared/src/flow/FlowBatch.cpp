@@ -0,0 +1,301 @@
+//
+//  FlowBatch.cpp
+//  shared
+//
+
+#include "FlowBatch.hpp"
+
+
+FlowBatch::FlowBatch(){
+}
+
+
+void FlowBatch::setup(const FlowSettings& _settings, float _scale){
+
+    settings = _settings;
+    scale = _scale > 0 ? _scale : 1;
+
+    // one worker per thread up front, settings applied to every worker's flow on acquire
+
+    std::lock_guard<std::mutex> lock(workerMutex);
+
+    int nThreads = TaskScheduler::get().getNumThreads();
+    while (workers.size() < nThreads){
+        workers.push_back(unique_ptr<Worker>(new Worker()));
+        freeWorkers.push_back(workers.back().get());
+    }
+}
+
+
+//--------------------------------------------------------------
+// SEGMENTS
+//--------------------------------------------------------------
+
+void FlowBatch::addClip(const string& path){
+
+    addSegment(path, 0, -1);
+}
+
+
+void FlowBatch::addSegment(const string& path, int startFrame, int endFrame){
+
+    Segment segment;
+    segment.path = ofToDataPath(path, true); // not safe from the tasks
+    segment.startFrame = max(startFrame, 0);
+    segment.endFrame = endFrame;
+
+    segments.push_back(segment);
+}
+
+
+void FlowBatch::addSegments(const string& path, int nSegments, int startFrame, int endFrame){
+
+    if (endFrame < 0){
+        endFrame = getFrameCount(path);
+    }
+
+    int nFrames = endFrame - startFrame;
+    nSegments = ofClamp(nSegments, 1, max(nFrames, 1));
+
+    for (int i=0; i<nSegments; i++){
+        addSegment(path, startFrame + nFrames * i / nSegments, startFrame + nFrames * (i+1) / nSegments);
+    }
+}
+
+
+bool FlowBatch::addCachedSegments(const string& cachePath, int nSegments){
+
+    unique_ptr<FrameCache> cache(new FrameCache());
+
+    if (!cache->open(cachePath)){
+        ofLogError("FlowBatch") << "couldn't open frame cache " << cachePath;
+        return false;
+    }
+
+    int nFrames = cache->getNumFrames();
+    nSegments = ofClamp(nSegments, 1, max(nFrames, 1));
+
+    for (int i=0; i<nSegments; i++){
+        Segment segment;
+        segment.path = cachePath;
+        segment.cache = caches.size();
+        segment.startFrame = nFrames * i / nSegments; // cache frames, not source frames
+        segment.endFrame = nFrames * (i+1) / nSegments;
+        segments.push_back(segment);
+    }
+
+    caches.push_back(std::move(cache));
+    return true;
+}
+
+
+void FlowBatch::clear(){
+
+    segments.clear();
+    caches.clear();
+    segmentResults.clear();
+    results.clear();
+}
+
+
+int FlowBatch::getNumSegments() const{
+
+    return segments.size();
+}
+
+
+int FlowBatch::getFrameCount(const string& path){
+
+    VideoCapture capture(ofToDataPath(path, true));
+    if (!capture.isOpened()) return 0;
+
+    return capture.get(CV_CAP_PROP_FRAME_COUNT);
+}
+
+
+//--------------------------------------------------------------
+// RUN
+//--------------------------------------------------------------
+
+const vector<FlowBatch::FrameResult>& FlowBatch::run(){
+
+    uint64_t startTime = ofGetElapsedTimeMillis();
+
+    if (workers.empty()) setup(settings, scale);
+
+    segmentResults.resize(segments.size());
+
+    TaskGroup group;
+
+    for (int s=0; s<segments.size(); s++){
+
+        group.run([this, s]{
+            Worker* worker = acquireWorker();
+            runSegment(s, *worker);
+            releaseWorker(worker);
+        });
+    }
+
+    group.wait();
+
+
+    // merge in segment order
+
+    results.clear();
+    for (auto& segment : segmentResults){
+        results.insert(results.end(), segment.begin(), segment.end());
+    }
+
+    ofLogNotice("FlowBatch") << results.size() << " frames in " << segments.size() << " segments took "
+    << ofGetElapsedTimeMillis() - startTime << " ms on " << TaskScheduler::get().getNumThreads() << " threads";
+
+    return results;
+}
+
+
+void FlowBatch::runSegment(int s, Worker& worker){
+
+    const Segment& segment = segments[s];
+    vector<FrameResult>& frames = segmentResults[s];
+    frames.clear();
+    if (segment.endFrame > 0) frames.reserve(segment.endFrame - segment.startFrame);
+
+    if (segment.cache >= 0){
+        runCachedSegment(s, worker);
+        return;
+    }
+
+    if (!worker.capture.open(segment.path)){
+        ofLogError("FlowBatch") << "couldn't open " << segment.path;
+        return;
+    }
+
+    // start one frame early, that frame is only the previous frame for the segment's first one.
+    // the frames before it are decoded and dropped (grab() skips the conversion) instead of seeking:
+    // a CV_CAP_PROP_POS_FRAMES seek can land a few frames off (ffmpeg + MP4), and then segments
+    // would overlap or leave gaps
+
+    int frame = 0;
+    while (frame < segment.startFrame - 1 && worker.capture.grab()) frame++;
+
+    settings.apply(worker.flow);
+    worker.flow.resetFlow(); // no flow against the last segment this worker had
+
+    // the first frame decoded here has no flow of its own, whatever the worker's flow Mat
+    // still holds from its last segment (resetFlow() doesn't release it), so it's counted, not getWidth()
+    int nDecoded = 0;
+
+    while (segment.endFrame < 0 || frame < segment.endFrame){
+
+        if (!worker.capture.read(worker.frame)) break; // end of the clip
+
+        cvtColor(worker.frame, worker.gray, CV_BGR2GRAY);
+
+        Mat* input = &worker.gray;
+        if (scale != 1){
+            resize(worker.gray, worker.scaled, cv::Size(), scale, scale, INTER_AREA);
+            input = &worker.scaled;
+        }
+
+        worker.flow.calcOpticalFlow(*input);
+        nDecoded++;
+
+        if (frame >= segment.startFrame && nDecoded > 1){
+            analyzeFrame(s, frame, worker);
+        }
+
+        frame++;
+    }
+
+    worker.capture.release();
+}
+
+
+void FlowBatch::runCachedSegment(int s, Worker& worker){
+
+    // same as runSegment, frames from the mapped cache instead of the decoder
+
+    const Segment& segment = segments[s];
+    const FrameCache& cache = *caches[segment.cache];
+
+    settings.apply(worker.flow);
+    worker.flow.resetFlow();
+
+    int first = max(segment.startFrame - 1, 0); // only the previous frame for the next one
+
+    for (int i = first; i < segment.endFrame; i++){
+
+        Mat input = cache.getFrame(i);
+        if (scale != 1){
+            resize(input, worker.scaled, cv::Size(), scale, scale, INTER_AREA);
+            input = worker.scaled;
+        }
+
+        worker.flow.calcOpticalFlow(input);
+
+        if (i >= segment.startFrame && i > first){
+            analyzeFrame(s, cache.getSourceFrame(i), worker);
+        }
+    }
+}
+
+
+void FlowBatch::analyzeFrame(int s, int frame, Worker& worker){
+
+    worker.stats.run(worker.flow.getFlow());
+    worker.motionEstimator.estimate(worker.flow.getFlow());
+
+    FrameResult result;
+    result.segment = s;
+    result.frame = frame;
+    result.average = worker.stats.getAverage();
+    result.averageMagnitude = worker.stats.getAverageMagnitude();
+    result.motion = worker.motionEstimator.getMotion();
+
+    segmentResults[s].push_back(result);
+}
+
+
+//--------------------------------------------------------------
+// WORKERS
+// one per thread: a thread waiting inside a segment (the motion estimator's parallelFor)
+// only helps with that wait's own tasks, never another segment. more are only made
+// if the scheduler got more threads since setup()
+//--------------------------------------------------------------
+
+FlowBatch::Worker* FlowBatch::acquireWorker(){
+
+    std::lock_guard<std::mutex> lock(workerMutex);
+
+    if (freeWorkers.empty()){
+        workers.push_back(unique_ptr<Worker>(new Worker()));
+        return workers.back().get();
+    }
+
+    Worker* worker = freeWorkers.back();
+    freeWorkers.pop_back();
+    return worker;
+}
+
+
+void FlowBatch::releaseWorker(Worker* worker){
+
+    std::lock_guard<std::mutex> lock(workerMutex);
+    freeWorkers.push_back(worker);
+}
+
+
+//--------------------------------------------------------------
+// RESULTS
+//--------------------------------------------------------------
+
+const vector<FlowBatch::FrameResult>& FlowBatch::getResults() const{
+
+    return results;
+}
+
+
+const vector<FlowBatch::FrameResult>& FlowBatch::getSegmentResults(int segment) const{
+
+    return segmentResults[segment];
+}
@@ -0,0 +1,108 @@
+//
+//  FlowBatch.hpp
+//  shared
+//
+
+#pragma once
+#include "ofMain.h"
+
+#include "ofxOpenCv.h"
+#include "ofxCv.h"
+
+#include "FlowSettings.hpp"
+#include "FlowStats.hpp"
+#include "FlowMotionEstimator.hpp"
+#include "TaskScheduler.hpp"
+#include "FrameCache.hpp"
+
+using namespace cv;
+using namespace ofxCv;
+
+
+// flow analysis of many clips (or segments of one film) at once, headless.
+// Farneback is sequential frame to frame, but separate segments aren't, so every segment
+// is a TaskScheduler task with its own worker: decoder, FlowFarneback state, FlowStats,
+// FlowMotionEstimator and frame buffers, all reused from segment to segment.
+// results come back merged in segment order, whatever order the segments finished in.
+//
+// a segment also decodes the frame before its first one (if there is one) as the previous frame,
+// so splitting a clip gives the same frames flow as one pass over it; splits at cuts lose nothing at all.
+// segments don't seek (not frame-accurate with every codec), they decode and drop the frames before
+// their start: every segment of a long clip decodes the clip up to it, where a FrameCache is faster.
+//
+// frames are decoded with cv::VideoCapture (one per worker, no GL or ofVideoPlayer),
+// so OpenCV has to be built with video I/O. segments of a FrameCache skip the decoding:
+// their frames come straight off the mapped file, shared by all workers
+
+class FlowBatch {
+
+public:
+
+    struct Segment {
+        string path;
+        int cache = -1; // index into caches, -1 = decode path
+        int startFrame = 0;
+        int endFrame = -1; // exclusive, -1 = to the end of the clip
+    };
+
+    struct FrameResult {
+        int segment = 0;
+        int frame = 0; // in the segment's clip (the source clip for cached segments)
+        Point2f average; // mean flow, px per frame (at the batch's scale)
+        float averageMagnitude = 0;
+        FlowMotion motion; // camera motion
+    };
+
+    FlowBatch();
+
+    void setup(const FlowSettings& _settings = FlowSettings(), float _scale = 1);
+    // scale < 1 downscales frames before the flow (i.e. 0.5 for 1080p sources)
+
+    void addClip(const string& path); // whole clip as one segment
+    void addSegment(const string& path, int startFrame, int endFrame = -1);
+    void addSegments(const string& path, int nSegments, int startFrame = 0, int endFrame = -1);
+    // frames startFrame to endFrame of path split evenly into nSegments
+    bool addCachedSegments(const string& cachePath, int nSegments = 1);
+    // all frames of a FrameCache split evenly into nSegments. the cache's frames are already
+    // gray and at the cache's scale, the batch's scale comes on top of that
+    void clear();
+
+    const vector<FrameResult>& run();
+    // all segments, as many at once as the TaskScheduler has threads. blocks until done
+
+    const vector<FrameResult>& getResults() const; // all frames of all segments, in segment order
+    const vector<FrameResult>& getSegmentResults(int segment) const;
+    int getNumSegments() const;
+
+    static int getFrameCount(const string& path); // 0 if it can't be opened
+
+private:
+
+    struct Worker {
+        VideoCapture capture;
+        FlowFarneback flow;
+        FlowStats stats;
+        FlowMotionEstimator motionEstimator;
+        Mat frame, gray, scaled;
+    };
+
+    void runSegment(int segment, Worker& worker);
+    void runCachedSegment(int segment, Worker& worker);
+    void analyzeFrame(int segment, int frame, Worker& worker); // stats + motion of the flow's current field
+
+    Worker* acquireWorker();
+    void releaseWorker(Worker* worker);
+
+    FlowSettings settings;
+    float scale = 1;
+
+    vector<Segment> segments;
+    vector<unique_ptr<FrameCache>> caches; // opened by addCachedSegments, read from all tasks
+    vector<vector<FrameResult>> segmentResults; // one per segment, each filled by its own task
+    vector<FrameResult> results;
+
+    vector<unique_ptr<Worker>> workers; // all created so far
+    vector<Worker*> freeWorkers;
+    std::mutex workerMutex;
+
+};
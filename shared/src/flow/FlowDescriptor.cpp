@@ -0,0 +1,329 @@
+//
+//  FlowDescriptor.cpp
+//  optFlowTest
+//
+
+#include "FlowDescriptor.hpp"
+
+
+//--------------------------------------------------------------
+// FlowDescriptor
+//--------------------------------------------------------------
+
+FlowDescriptor::FlowDescriptor(){
+    setup();
+}
+
+void FlowDescriptor::setup(int _nCellsX, int _nCellsY, int _nOrientBins, float _maxMag, float _minMag){
+
+    nCellsX = max(1, _nCellsX);
+    nCellsY = max(1, _nCellsY);
+    nOrientBins = max(1, _nOrientBins);
+    maxMag = _maxMag;
+    minMag = _minMag;
+
+    descriptor.assign(nCellsX * nCellsY * (2 + nOrientBins), 0);
+    cellCounts.assign(nCellsX * nCellsY, 0);
+
+    flowW = flowH = 0; // force scratch resize on next compute()
+}
+
+
+//--------------------------------------------------------------
+// COMPUTE
+// same row-wise scheme as FlowStats::run():
+// per-pixel magnitude + orientation bin first (vectorizable),
+// then one scatter loop into the cells of the current row
+//--------------------------------------------------------------
+
+void FlowDescriptor::compute(const Mat& flow){
+
+    std::fill(descriptor.begin(), descriptor.end(), 0.f);
+    std::fill(cellCounts.begin(), cellCounts.end(), 0);
+
+    if (flow.empty() || flow.type() != CV_32FC2) {
+        return; // no flow yet (first frame after a reset)
+    }
+
+    if (flow.cols != flowW || flow.rows != flowH){
+
+        flowW = flow.cols;
+        flowH = flow.rows;
+
+        rowMag.resize(flowW);
+        rowBin.resize(flowW);
+        colCell.resize(flowW);
+
+        for (int x=0; x<flowW; x++){
+            colCell[x] = x * nCellsX / flowW;
+        }
+    }
+
+    const int stride = 2 + nOrientBins;
+    const float binScale = nOrientBins / TWO_PI;
+    const int lastBin = nOrientBins - 1;
+
+    float* mag = &rowMag[0];
+    int* bin = &rowBin[0];
+
+    for (int y=0; y<flowH; y++){
+
+        const float* f = flow.ptr<float>(y); // interleaved x,y
+        int cellRow = (y * nCellsY / flowH) * nCellsX;
+
+        for (int x=0; x<flowW; x++){
+
+            float fx = f[x*2], fy = f[x*2+1];
+            float m = sqrtf(fx*fx + fy*fy);
+
+            mag[x] = (m >= minMag) ? m : 0.f;
+            bin[x] = min((int) (flowAngle(fx, fy) * binScale), lastBin);
+        }
+
+        for (int x=0; x<flowW; x++){
+
+            int cell = cellRow + colCell[x];
+            float* d = &descriptor[cell * stride];
+
+            d[0] += f[x*2];
+            d[1] += f[x*2+1];
+            d[2 + bin[x]] += mag[x];
+            cellCounts[cell]++;
+        }
+    }
+
+
+    // sums -> mean flow, hof -> L1 normalized
+
+    for (int i=0; i<nCellsX*nCellsY; i++){
+
+        float* d = &descriptor[i * stride];
+
+        if (cellCounts[i] > 0){
+            d[0] /= cellCounts[i];
+            d[1] /= cellCounts[i];
+        }
+
+        float hofTotal = 0;
+        for (int b=0; b<nOrientBins; b++) hofTotal += d[2+b];
+
+        if (hofTotal > 0){
+            for (int b=0; b<nOrientBins; b++) d[2+b] /= hofTotal;
+        }
+    }
+}
+
+
+//--------------------------------------------------------------
+// QUANTIZE
+// mean flow: -maxMag..maxMag -> 0..255, hof: 0..1 -> 0..255
+//--------------------------------------------------------------
+
+void FlowDescriptor::quantize(vector<uchar>& code) const{
+
+    code.resize(descriptor.size());
+
+    const int stride = 2 + nOrientBins;
+    const float flowScale = 127.5f / maxMag;
+
+    for (int i=0; i<descriptor.size(); i++){
+
+        float v;
+
+        if (i % stride < 2){
+            v = descriptor[i] * flowScale + 127.5f;
+        } else {
+            v = descriptor[i] * 255.f;
+        }
+
+        code[i] = saturate_cast<uchar>(v);
+    }
+}
+
+const vector<float>& FlowDescriptor::getDescriptor() const{
+    return descriptor;
+}
+
+int FlowDescriptor::size() const{
+    return descriptor.size();
+}
+
+int FlowDescriptor::getNCellsX() const{
+    return nCellsX;
+}
+
+int FlowDescriptor::getNCellsY() const{
+    return nCellsY;
+}
+
+int FlowDescriptor::getNOrientBins() const{
+    return nOrientBins;
+}
+
+
+//--------------------------------------------------------------
+// FlowDescriptorIndex
+//--------------------------------------------------------------
+
+FlowDescriptorIndex::FlowDescriptorIndex(){
+}
+
+void FlowDescriptorIndex::setup(int _descriptorSize){
+
+    descriptorSize = _descriptorSize;
+    clear();
+}
+
+void FlowDescriptorIndex::add(const vector<uchar>& code, int clip, int frame){
+
+    if (code.size() != descriptorSize) {
+        ofLogError("FlowDescriptorIndex") << "descriptor size " << code.size() << " doesn't match index size " << descriptorSize;
+        return;
+    }
+
+    codes.insert(codes.end(), code.begin(), code.end());
+    clips.push_back(clip);
+    frames.push_back(frame);
+}
+
+void FlowDescriptorIndex::clear(){
+
+    codes.clear();
+    clips.clear();
+    frames.clear();
+}
+
+int FlowDescriptorIndex::size() const{
+    return frames.size();
+}
+
+int FlowDescriptorIndex::getDescriptorSize() const{
+    return descriptorSize;
+}
+
+
+//--------------------------------------------------------------
+// SEARCH
+// linear scan over the packed codes - fixed size byte vectors
+// stream through cache and the distance loop vectorizes,
+// so a feature film (~150k frames) is a few ms
+//--------------------------------------------------------------
+
+void FlowDescriptorIndex::search(const vector<uchar>& query, int k, vector<Match>& results) const{
+
+    results.clear();
+
+    if (query.size() != descriptorSize || size() == 0) return;
+
+    k = min(k, size());
+
+    // keep the k best in a max-heap on distance
+
+    vector<pair<int,int>> heap; // (squared distance, frame index)
+    heap.reserve(k + 1);
+
+    const uchar* q = &query[0];
+
+    for (int i=0; i<size(); i++){
+
+        const uchar* c = &codes[i * descriptorSize];
+        int dist = 0;
+
+        for (int j=0; j<descriptorSize; j++){
+            int d = (int) q[j] - (int) c[j];
+            dist += d*d;
+        }
+
+        if (heap.size() < k){
+            heap.push_back(make_pair(dist, i));
+            push_heap(heap.begin(), heap.end());
+        } else if (dist < heap.front().first){
+            pop_heap(heap.begin(), heap.end());
+            heap.back() = make_pair(dist, i);
+            push_heap(heap.begin(), heap.end());
+        }
+    }
+
+    sort_heap(heap.begin(), heap.end()); // closest first
+
+    for (int i=0; i<heap.size(); i++){
+        Match m;
+        m.clip = clips[heap[i].second];
+        m.frame = frames[heap[i].second];
+        m.distance = sqrtf(heap[i].first);
+        results.push_back(m);
+    }
+}
+
+
+//--------------------------------------------------------------
+// SAVE / LOAD
+// raw binary: descriptor size, # frames, then clip/frame ids and codes
+//--------------------------------------------------------------
+
+bool FlowDescriptorIndex::save(string path) const{
+
+    ofstream file(ofToDataPath(path).c_str(), ios::binary);
+    if (!file) return false;
+
+    int n = size();
+    file.write((const char*) &descriptorSize, sizeof(int));
+    file.write((const char*) &n, sizeof(int));
+
+    if (n > 0){
+        file.write((const char*) &clips[0], n * sizeof(int));
+        file.write((const char*) &frames[0], n * sizeof(int));
+        file.write((const char*) &codes[0], codes.size());
+    }
+
+    return file.good();
+}
+
+bool FlowDescriptorIndex::load(string path){
+
+    // everything is read into locals and checked first, a bad file leaves the index as it was
+
+    string fullPath = ofToDataPath(path);
+    ifstream file(fullPath.c_str(), ios::binary);
+    if (!file) return false;
+
+    int fileDescriptorSize = 0, n = 0;
+    file.read((char*) &fileDescriptorSize, sizeof(int));
+    file.read((char*) &n, sizeof(int));
+    if (!file || n < 0 || fileDescriptorSize <= 0) return false;
+
+    if (descriptorSize > 0 && fileDescriptorSize != descriptorSize){
+        ofLogError("FlowDescriptorIndex") << fullPath << " has descriptors of " << fileDescriptorSize
+        << " bytes, this index was set up for " << descriptorSize;
+        return false;
+    }
+
+    // the file has to be exactly as long as its counts say (64-bit math, n * size can overflow an int)
+
+    uint64_t expected = 2 * sizeof(int) + (uint64_t) n * (2 * sizeof(int) + fileDescriptorSize);
+
+    file.seekg(0, ios::end);
+    if ((uint64_t) file.tellg() != expected){
+        ofLogError("FlowDescriptorIndex") << fullPath << " is truncated or damaged";
+        return false;
+    }
+    file.seekg(2 * sizeof(int));
+
+    vector<int> fileClips(n), fileFrames(n);
+    vector<uchar> fileCodes((size_t) n * fileDescriptorSize);
+
+    if (n > 0){
+        file.read((char*) &fileClips[0], n * sizeof(int));
+        file.read((char*) &fileFrames[0], n * sizeof(int));
+        file.read((char*) &fileCodes[0], fileCodes.size());
+    }
+
+    if (!file) return false;
+
+    descriptorSize = fileDescriptorSize;
+    clips.swap(fileClips);
+    frames.swap(fileFrames);
+    codes.swap(fileCodes);
+
+    return true;
+}
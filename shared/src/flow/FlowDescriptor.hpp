@@ -0,0 +1,95 @@
+//
+//  FlowDescriptor.hpp
+//  optFlowTest
+//
+
+#pragma once
+#include "ofMain.h"
+
+#include "ofxOpenCv.h"
+#include "ofxCv.h"
+
+#include "FlowStats.hpp" // flowAngle()
+
+using namespace cv;
+using namespace ofxCv;
+
+
+// gridded motion descriptor of one frame
+// per cell: mean flow (x,y) + histogram of oriented flow (magnitude weighted, sums to 1)
+// layout: [cell0 meanX, meanY, hof0..hofN-1, cell1 meanX, ...]
+
+class FlowDescriptor {
+
+public:
+
+    FlowDescriptor();
+
+    void setup(int _nCellsX = 4, int _nCellsY = 4, int _nOrientBins = 8, float _maxMag = 8, float _minMag = 0.1);
+    // maxMag = mean flow range used when quantizing (px/frame)
+    // minMag = vectors slower than this don't vote in the orientation histogram (noise)
+
+    void compute(const Mat& flow);
+    // single pass over a CV_32FC2 flow field (i.e. FlowFarneback::getFlow())
+
+    const vector<float>& getDescriptor() const;
+    int size() const; // # of floats (and bytes when quantized) per frame
+
+    void quantize(vector<uchar>& code) const;
+    // compacts the descriptor to one byte per value, for storing whole films
+
+    int getNCellsX() const;
+    int getNCellsY() const;
+    int getNOrientBins() const;
+
+private:
+
+    int nCellsX = 4, nCellsY = 4, nOrientBins = 8;
+    float maxMag = 8, minMag = 0.1;
+    int flowW = 0, flowH = 0;
+
+    vector<int> colCell; // cell column of each flow column
+    vector<float> rowMag;
+    vector<int> rowBin;
+    vector<int> cellCounts;
+
+    vector<float> descriptor;
+
+};
+
+
+// stores quantized descriptors of many frames back to back
+// and finds the frames with the most similar motion (brute force L2 over bytes)
+
+class FlowDescriptorIndex {
+
+public:
+
+    struct Match {
+        int clip, frame;
+        float distance;
+    };
+
+    FlowDescriptorIndex();
+
+    void setup(int _descriptorSize);
+    void add(const vector<uchar>& code, int clip, int frame);
+    void clear();
+
+    int size() const; // # of stored frames
+    int getDescriptorSize() const;
+
+    void search(const vector<uchar>& query, int k, vector<Match>& results) const;
+    // k nearest frames to query, closest first
+
+    bool save(string path) const;
+    bool load(string path);
+    // false (index unchanged) if the file is damaged or its descriptor size isn't the one from setup()
+
+private:
+
+    int descriptorSize = 0;
+    vector<uchar> codes;
+    vector<int> clips, frames;
+
+};
@@ -0,0 +1,388 @@
+//
+//  FlowMotionEstimator.cpp
+//  optFlowTest
+//
+
+#include "FlowMotionEstimator.hpp"
+
+
+//--------------------------------------------------------------
+// RANSAC scoring body
+// each hypothesis is scored independently, so the TaskScheduler
+// can spread them over all cores (one chunk = a few hypotheses)
+//--------------------------------------------------------------
+
+namespace {
+
+    class ScoreHypotheses : public ParallelLoopBody {
+
+    public:
+
+        ScoreHypotheses(const vector<Point2f>& _src, const vector<Point2f>& _dst,
+                        const vector<Matx23f>& _models, vector<int>& _scores, float _threshold)
+        : src(_src), dst(_dst), models(_models), scores(_scores), threshSq(_threshold*_threshold) {}
+
+        void operator()(const Range& range) const {
+
+            const int n = src.size();
+
+            for (int h = range.start; h < range.end; h++){
+
+                const Matx23f& m = models[h];
+                int score = 0;
+
+                for (int i=0; i<n; i++){
+
+                    // residual between where the model puts the sample and where the flow put it
+                    float rx = m(0,0)*src[i].x + m(0,1)*src[i].y + m(0,2) - dst[i].x;
+                    float ry = m(1,0)*src[i].x + m(1,1)*src[i].y + m(1,2) - dst[i].y;
+
+                    score += (rx*rx + ry*ry < threshSq);
+                }
+
+                scores[h] = score;
+            }
+        }
+
+    private:
+
+        const vector<Point2f>& src;
+        const vector<Point2f>& dst;
+        const vector<Matx23f>& models;
+        vector<int>& scores;
+        float threshSq;
+
+    };
+
+
+    // solves a 3x3 system (row major A) by Cramer's rule, returns false if singular
+
+    bool solve3x3(const double A[9], const double b[3], double x[3]){
+
+        double det = A[0]*(A[4]*A[8] - A[5]*A[7])
+                   - A[1]*(A[3]*A[8] - A[5]*A[6])
+                   + A[2]*(A[3]*A[7] - A[4]*A[6]);
+
+        if (fabs(det) < 1e-9) return false;
+
+        x[0] = ( b[0]*(A[4]*A[8] - A[5]*A[7]) - A[1]*(b[1]*A[8] - A[5]*b[2]) + A[2]*(b[1]*A[7] - A[4]*b[2]) ) / det;
+        x[1] = ( A[0]*(b[1]*A[8] - A[5]*b[2]) - b[0]*(A[3]*A[8] - A[5]*A[6]) + A[2]*(A[3]*b[2] - b[1]*A[6]) ) / det;
+        x[2] = ( A[0]*(A[4]*b[2] - b[1]*A[7]) - A[1]*(A[3]*b[2] - b[1]*A[6]) + b[0]*(A[3]*A[7] - A[4]*A[6]) ) / det;
+
+        return true;
+    }
+
+}
+
+
+//--------------------------------------------------------------
+// Constructor
+//--------------------------------------------------------------
+
+FlowMotionEstimator::FlowMotionEstimator()
+: rng(0x5eed), transform(1,0,0, 0,1,0) {
+}
+
+void FlowMotionEstimator::setup(int _sampleStep, Model _model){
+
+    sampleStep = max(1, _sampleStep);
+    model = _model;
+}
+
+void FlowMotionEstimator::setModel(Model _model){
+    model = _model;
+}
+
+void FlowMotionEstimator::setRansacIterations(int _nIterations){
+    nRansacIterations = max(1, _nIterations);
+}
+
+void FlowMotionEstimator::setInlierThreshold(float _threshold){
+    inlierThreshold = _threshold;
+}
+
+void FlowMotionEstimator::setIrlsIterations(int _nIterations){
+    nIrlsIterations = max(0, _nIterations);
+}
+
+
+//--------------------------------------------------------------
+// ESTIMATE
+// 1. subsample the flow field
+// 2. RANSAC over minimal samples (parallel scoring)
+// 3. IRLS refinement of the best hypothesis (Huber weights)
+//--------------------------------------------------------------
+
+bool FlowMotionEstimator::estimate(const Mat& flow){
+
+    transform = Matx23f(1,0,0, 0,1,0);
+    motion = FlowMotion();
+
+    if (flow.empty() || flow.type() != CV_32FC2) {
+        return false; // no flow yet (first frame after a reset)
+    }
+
+    collectSamples(flow);
+
+    const int nMinimal = (model == MOTION_SIMILARITY) ? 2 : 3;
+    const int nSamples = srcPts.size();
+
+    if (nSamples < nMinimal * 4) {
+        return false; // too few samples to be meaningful
+    }
+
+
+    // draw minimal sample sets up front so scoring can run in parallel
+    // rng is re-seeded every frame so results are repeatable
+
+    rng.state = 0x5eed;
+
+    hypIdx.resize(nRansacIterations * 3);
+    hypModels.resize(nRansacIterations);
+    hypScores.assign(nRansacIterations, 0);
+
+    for (int h=0; h<nRansacIterations; h++){
+
+        int* idx = &hypIdx[h*3];
+
+        for (int k=0; k<nMinimal; k++){
+            idx[k] = rng.uniform(0, nSamples);
+        }
+
+        if (!fitMinimal(idx, hypModels[h])) {
+            hypModels[h] = Matx23f(0,0,1e6, 0,0,1e6); // degenerate sample, scores zero
+        }
+    }
+
+    ScoreHypotheses score(srcPts, dstPts, hypModels, hypScores, inlierThreshold);
+    TaskScheduler::get().parallelFor(0, nRansacIterations, 8, [&](int begin, int end){ score(Range(begin, end)); });
+
+
+    // keep the hypothesis with the most support
+
+    int best = 0;
+    for (int h=1; h<nRansacIterations; h++){
+        if (hypScores[h] > hypScores[best]) best = h;
+    }
+
+    if (hypScores[best] < nMinimal) {
+        return false; // nothing agrees, e.g. a flash frame
+    }
+
+    Matx23f m = hypModels[best];
+
+    refine(m);
+    decompose(m);
+
+    return true;
+}
+
+
+//--------------------------------------------------------------
+// read every sampleStep-th vector into srcPts/dstPts
+// coordinates are centered on the frame so rotation/zoom are about the center
+//--------------------------------------------------------------
+
+void FlowMotionEstimator::collectSamples(const Mat& flow){
+
+    center = Point2f(flow.cols * 0.5f, flow.rows * 0.5f);
+
+    int nx = (flow.cols + sampleStep - 1) / sampleStep;
+    int ny = (flow.rows + sampleStep - 1) / sampleStep;
+
+    srcPts.clear();
+    dstPts.clear();
+    srcPts.reserve(nx*ny); // no-op after the first frame
+    dstPts.reserve(nx*ny);
+
+    for (int y = sampleStep/2; y < flow.rows; y += sampleStep){
+
+        const Point2f* row = flow.ptr<Point2f>(y);
+
+        for (int x = sampleStep/2; x < flow.cols; x += sampleStep){
+
+            const Point2f& d = row[x];
+
+            if (d.x != d.x || d.y != d.y) continue; // skip NaNs
+
+            Point2f p(x - center.x, y - center.y);
+            srcPts.push_back(p);
+            dstPts.push_back(p + d);
+        }
+    }
+}
+
+
+//--------------------------------------------------------------
+// model from a minimal sample: 2 points for similarity, 3 for affine
+//--------------------------------------------------------------
+
+bool FlowMotionEstimator::fitMinimal(const int* idx, Matx23f& m) const{
+
+    if (model == MOTION_SIMILARITY){
+
+        // q = [a -b; b a] p + t
+        // (a + ib) = dq / dp as complex numbers
+
+        const Point2f& p0 = srcPts[idx[0]];
+        const Point2f& q0 = dstPts[idx[0]];
+        Point2f dp = srcPts[idx[1]] - p0;
+        Point2f dq = dstPts[idx[1]] - q0;
+
+        float len = dp.x*dp.x + dp.y*dp.y;
+        if (len < 1e-3f) return false; // same point twice
+
+        float a = (dq.x*dp.x + dq.y*dp.y) / len;
+        float b = (dq.y*dp.x - dq.x*dp.y) / len;
+
+        m = Matx23f(a, -b, q0.x - (a*p0.x - b*p0.y),
+                    b,  a, q0.y - (b*p0.x + a*p0.y));
+        return true;
+    }
+
+    // affine: each output row is an exact fit of [x y 1] through the 3 points
+
+    double A[9], bx[3], by[3], rx[3], ry[3];
+
+    for (int k=0; k<3; k++){
+        const Point2f& p = srcPts[idx[k]];
+        A[k*3+0] = p.x; A[k*3+1] = p.y; A[k*3+2] = 1;
+        bx[k] = dstPts[idx[k]].x;
+        by[k] = dstPts[idx[k]].y;
+    }
+
+    if (!solve3x3(A, bx, rx) || !solve3x3(A, by, ry)) return false; // collinear points
+
+    m = Matx23f(rx[0], rx[1], rx[2],
+                ry[0], ry[1], ry[2]);
+    return true;
+}
+
+
+//--------------------------------------------------------------
+// iteratively reweighted least squares over all samples
+// Huber weights: full weight inside the inlier threshold, 1/r falloff outside
+// so foreground motion is pushed down instead of being cut off hard
+//--------------------------------------------------------------
+
+void FlowMotionEstimator::refine(Matx23f& m){
+
+    const int n = srcPts.size();
+    const float k = inlierThreshold;
+
+    weights.resize(n);
+
+    for (int it=0; it<nIrlsIterations; it++){
+
+        for (int i=0; i<n; i++){
+            float rx = m(0,0)*srcPts[i].x + m(0,1)*srcPts[i].y + m(0,2) - dstPts[i].x;
+            float ry = m(1,0)*srcPts[i].x + m(1,1)*srcPts[i].y + m(1,2) - dstPts[i].y;
+            float r = sqrtf(rx*rx + ry*ry);
+            weights[i] = (r <= k) ? 1.f : k / r;
+        }
+
+        if (model == MOTION_SIMILARITY){
+
+            // weighted Procrustes (no reflection): center both sets, then closed form a,b
+
+            double sw = 0, spx = 0, spy = 0, sqx = 0, sqy = 0;
+            for (int i=0; i<n; i++){
+                sw += weights[i];
+                spx += weights[i]*srcPts[i].x; spy += weights[i]*srcPts[i].y;
+                sqx += weights[i]*dstPts[i].x; sqy += weights[i]*dstPts[i].y;
+            }
+            if (sw <= 0) return;
+            spx /= sw; spy /= sw; sqx /= sw; sqy /= sw;
+
+            double num_a = 0, num_b = 0, den = 0;
+            for (int i=0; i<n; i++){
+                double px = srcPts[i].x - spx, py = srcPts[i].y - spy;
+                double qx = dstPts[i].x - sqx, qy = dstPts[i].y - sqy;
+                num_a += weights[i] * (px*qx + py*qy);
+                num_b += weights[i] * (px*qy - py*qx);
+                den   += weights[i] * (px*px + py*py);
+            }
+            if (den <= 1e-9) return;
+
+            double a = num_a / den, b = num_b / den;
+
+            m = Matx23f(a, -b, sqx - (a*spx - b*spy),
+                        b,  a, sqy - (b*spx + a*spy));
+
+        } else {
+
+            // weighted normal equations, shared 3x3 matrix for both output rows
+
+            double A[9] = {0,0,0, 0,0,0, 0,0,0}, bx[3] = {0,0,0}, by[3] = {0,0,0}, rx[3], ry[3];
+
+            for (int i=0; i<n; i++){
+                double w = weights[i], x = srcPts[i].x, y = srcPts[i].y;
+                A[0] += w*x*x; A[1] += w*x*y; A[2] += w*x;
+                               A[4] += w*y*y; A[5] += w*y;
+                                              A[8] += w;
+                bx[0] += w*x*dstPts[i].x; bx[1] += w*y*dstPts[i].x; bx[2] += w*dstPts[i].x;
+                by[0] += w*x*dstPts[i].y; by[1] += w*y*dstPts[i].y; by[2] += w*dstPts[i].y;
+            }
+            A[3] = A[1]; A[6] = A[2]; A[7] = A[5]; // symmetric
+
+            if (!solve3x3(A, bx, rx) || !solve3x3(A, by, ry)) return;
+
+            m = Matx23f(rx[0], rx[1], rx[2],
+                        ry[0], ry[1], ry[2]);
+        }
+    }
+}
+
+
+//--------------------------------------------------------------
+// split the model into translation, rotation and zoom
+//--------------------------------------------------------------
+
+void FlowMotionEstimator::decompose(const Matx23f& m){
+
+    transform = m;
+
+    motion.translation = Point2f(m(0,2), m(1,2)); // displacement of the frame center
+    motion.rotation = atan2f(m(1,0) - m(0,1), m(0,0) + m(1,1));
+
+    if (model == MOTION_SIMILARITY){
+        motion.zoom = sqrtf(m(0,0)*m(0,0) + m(1,0)*m(1,0));
+    } else {
+        motion.zoom = sqrtf(fabsf(m(0,0)*m(1,1) - m(0,1)*m(1,0))); // area scale -> linear scale
+    }
+
+    // final inlier count against the refined model
+
+    const float threshSq = inlierThreshold * inlierThreshold;
+    int nInliers = 0;
+
+    for (int i=0; i<srcPts.size(); i++){
+        float rx = m(0,0)*srcPts[i].x + m(0,1)*srcPts[i].y + m(0,2) - dstPts[i].x;
+        float ry = m(1,0)*srcPts[i].x + m(1,1)*srcPts[i].y + m(1,2) - dstPts[i].y;
+        nInliers += (rx*rx + ry*ry < threshSq);
+    }
+
+    motion.inlierRatio = (float) nInliers / srcPts.size();
+}
+
+
+//--------------------------------------------------------------
+// GETTERS
+//--------------------------------------------------------------
+
+const FlowMotion& FlowMotionEstimator::getMotion() const{
+    return motion;
+}
+
+const Matx23f& FlowMotionEstimator::getTransform() const{
+    return transform;
+}
+
+Point2f FlowMotionEstimator::getFlowAt(float x, float y) const{
+
+    Point2f p(x - center.x, y - center.y);
+    const Matx23f& m = transform;
+
+    return Point2f(m(0,0)*p.x + m(0,1)*p.y + m(0,2) - p.x,
+                   m(1,0)*p.x + m(1,1)*p.y + m(1,2) - p.y);
+}
@@ -0,0 +1,86 @@
+//
+//  FlowMotionEstimator.hpp
+//  optFlowTest
+//
+
+#pragma once
+#include "ofMain.h"
+
+#include "ofxOpenCv.h"
+#include "ofxCv.h"
+
+#include "TaskScheduler.hpp"
+
+using namespace cv;
+using namespace ofxCv;
+
+
+// global (camera) motion of one frame, relative to the frame center
+
+struct FlowMotion {
+
+    Point2f translation = Point2f(0,0); // px per frame
+    float rotation = 0; // radians per frame, positive is clockwise on screen (y down)
+    float zoom = 1; // scale per frame, > 1 is zooming in
+    float inlierRatio = 0; // share of flow samples that agree with the model
+
+};
+
+
+class FlowMotionEstimator {
+
+public:
+
+    enum Model {
+        MOTION_SIMILARITY,  // translation + rotation + uniform zoom (4 dof)
+        MOTION_AFFINE       // full 2x3 affine (6 dof), also catches shear / anamorphic zoom
+    };
+
+    FlowMotionEstimator();
+
+    void setup(int _sampleStep = 8, Model _model = MOTION_SIMILARITY);
+    // sampleStep = read every n-th flow vector in x and y
+
+    void setModel(Model _model);
+    void setRansacIterations(int _nIterations); // # of minimal-sample hypotheses per frame
+    void setInlierThreshold(float _threshold); // px, max residual for a sample to count as inlier
+    void setIrlsIterations(int _nIterations); // # of reweighted least squares passes after RANSAC
+
+    bool estimate(const Mat& flow);
+    // fits the global motion model to a CV_32FC2 flow field (i.e. FlowFarneback::getFlow())
+    // returns false (and keeps a zero motion) if there weren't enough usable samples
+
+    const FlowMotion& getMotion() const;
+    const Matx23f& getTransform() const; // fitted model, in coords centered on the frame
+
+    Point2f getFlowAt(float x, float y) const;
+    // model-predicted flow at (x,y) in flow image coords
+
+private:
+
+    void collectSamples(const Mat& flow);
+    bool fitMinimal(const int* idx, Matx23f& m) const;
+    void refine(Matx23f& m);
+    void decompose(const Matx23f& m);
+
+    int sampleStep = 8;
+    Model model = MOTION_SIMILARITY;
+    int nRansacIterations = 64;
+    float inlierThreshold = 0.5;
+    int nIrlsIterations = 3;
+
+    Point2f center;
+
+    // persistent buffers, reused frame to frame
+    vector<Point2f> srcPts, dstPts; // sample positions + where the flow moves them
+    vector<int> hypIdx; // minimal sample indices, 3 per hypothesis
+    vector<Matx23f> hypModels;
+    vector<int> hypScores;
+    vector<float> weights;
+
+    RNG rng;
+
+    Matx23f transform;
+    FlowMotion motion;
+
+};
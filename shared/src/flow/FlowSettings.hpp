@@ -0,0 +1,45 @@
+//
+//  FlowSettings.hpp
+//  shared
+//
+
+#pragma once
+#include "ofMain.h"
+
+#include "ofxOpenCv.h"
+#include "ofxCv.h"
+
+using namespace cv;
+using namespace ofxCv;
+
+
+// one set of Farneback parameters, as in optFlowTest's gui (the defaults are the gui's defaults),
+// so headless runs can set up their FlowFarneback objects the same way
+
+struct FlowSettings {
+
+    float pyrScale = 0.5; // scale between pyramid levels
+    int levels = 4; // # of pyramid levels
+    int winSize = 32; // averaging window size
+    int iterations = 2; // # of iterations at each pyramid level
+    int polyN = 7; // pixel neighborhood for the polynomial expansion
+    float polySigma = 1.5; // gaussian std dev for the polynomial expansion
+    bool bUseGaussian = true; // gaussian window instead of a box filter
+
+    void apply(FlowFarneback& flow) const {
+        flow.setPyramidScale(pyrScale);
+        flow.setNumLevels(levels);
+        flow.setWindowSize(winSize);
+        flow.setNumIterations(iterations);
+        flow.setPolyN(polyN);
+        flow.setPolySigma(polySigma);
+        flow.setUseGaussian(bUseGaussian);
+    }
+
+    string toString() const {
+        return "pyrScale " + ofToString(pyrScale) + ", levels " + ofToString(levels) + ", winSize " + ofToString(winSize)
+        + ", iterations " + ofToString(iterations) + ", polyN " + ofToString(polyN) + ", polySigma " + ofToString(polySigma)
+        + (bUseGaussian ? ", gaussian" : ", box");
+    }
+
+};
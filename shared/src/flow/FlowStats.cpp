@@ -0,0 +1,259 @@
+//
+//  FlowStats.cpp
+//  optFlowTest
+//
+
+#include "FlowStats.hpp"
+
+
+//--------------------------------------------------------------
+// Constructor
+//--------------------------------------------------------------
+
+FlowStats::FlowStats(){
+    setup();
+}
+
+void FlowStats::setup(int _nMagBins, float _maxMag, int _nAngleBins, int _nRegionsX, int _nRegionsY){
+
+    nMagBins = max(1, _nMagBins);
+    maxMag = _maxMag;
+    if (!(maxMag > 0)){ // 0 (or NaN) would put every vector at NaN * inf, outside the bins
+        ofLogWarning("FlowStats") << "maxMag has to be > 0, using 8";
+        maxMag = 8;
+    }
+    nAngleBins = max(1, _nAngleBins);
+    nRegionsX = max(1, _nRegionsX);
+    nRegionsY = max(1, _nRegionsY);
+
+    magHist.assign(nMagBins, 0);
+    angleHist.assign(nAngleBins, 0);
+    regionAvgs.assign(nRegionsX * nRegionsY, Point2f(0,0));
+    regionSums.assign(nRegionsX * nRegionsY * 2, 0);
+    regionX.assign(nRegionsX + 1, 0);
+
+    flowW = flowH = 0; // force scratch resize on next run()
+}
+
+
+//--------------------------------------------------------------
+// RUN
+// one pass over the flow field, row by row:
+//   1. per-pixel magnitude + bin indices into row scratch (vectorizable, no branches)
+//   2. scatter bin indices into the histograms
+//   3. sum each region's span of the row (vectorizable reduction)
+// the row is still in cache for steps 2 and 3
+//--------------------------------------------------------------
+
+void FlowStats::run(const Mat& flow){
+
+    std::fill(magHist.begin(), magHist.end(), 0);
+    std::fill(angleHist.begin(), angleHist.end(), 0.f);
+    std::fill(regionSums.begin(), regionSums.end(), 0.0);
+    std::fill(regionAvgs.begin(), regionAvgs.end(), Point2f(0,0));
+    avg = Point2f(0,0);
+    avgMag = 0;
+
+    if (flow.empty() || flow.type() != CV_32FC2) {
+        return; // no flow yet (first frame after a reset)
+    }
+
+    if (flow.cols != flowW || flow.rows != flowH){
+
+        // only happens on the first frame or if the video size changes
+
+        flowW = flow.cols;
+        flowH = flow.rows;
+
+        rowMag.resize(flowW);
+        rowMagBin.resize(flowW);
+        rowAngleBin.resize(flowW);
+
+        for (int c=0; c<=nRegionsX; c++){
+            regionX[c] = flowW * c / nRegionsX;
+        }
+    }
+
+    const float magScale = nMagBins / maxMag;
+    const float angleScale = nAngleBins / TWO_PI;
+    const int lastMagBin = nMagBins - 1;
+    const int lastAngleBin = nAngleBins - 1;
+
+    float* mag = &rowMag[0];
+    int* magBin = &rowMagBin[0];
+    int* angleBin = &rowAngleBin[0];
+
+    double totalX = 0, totalY = 0, totalMag = 0;
+
+    for (int y=0; y<flowH; y++){
+
+        const float* f = flow.ptr<float>(y); // interleaved x,y
+        double* sums = &regionSums[(y * nRegionsY / flowH) * nRegionsX * 2];
+
+        // 1. magnitude + bins
+
+        for (int x=0; x<flowW; x++){
+
+            float fx = f[x*2], fy = f[x*2+1];
+            float m = sqrtf(fx*fx + fy*fy);
+
+            if (!std::isfinite(m)){ // NaN / inf vector: no bin (converting it to int is undefined)
+                mag[x] = 0;
+                magBin[x] = -1;
+                continue;
+            }
+
+            // clamped as floats, so huge magnitudes don't overflow the int either
+            mag[x] = m;
+            magBin[x] = (int) ofClamp(m * magScale, 0, lastMagBin);
+            angleBin[x] = (int) ofClamp(flowAngle(fx, fy) * angleScale, 0, lastAngleBin);
+        }
+
+        // 2. histograms
+
+        float rowMagTotal = 0;
+
+        for (int x=0; x<flowW; x++){
+            if (magBin[x] < 0) continue;
+            magHist[magBin[x]]++;
+            angleHist[angleBin[x]] += mag[x]; // weight by magnitude, tiny vectors have noisy angles
+            rowMagTotal += mag[x];
+        }
+
+        totalMag += rowMagTotal;
+
+        // 3. region sums
+
+        for (int c=0; c<nRegionsX; c++){
+
+            float sx = 0, sy = 0;
+
+            for (int x=regionX[c]; x<regionX[c+1]; x++){
+                if (magBin[x] < 0) continue; // non-finite vectors count as no motion
+                sx += f[x*2];
+                sy += f[x*2+1];
+            }
+
+            sums[c*2] += sx;
+            sums[c*2+1] += sy;
+            totalX += sx;
+            totalY += sy;
+        }
+    }
+
+
+    // sums -> averages
+
+    for (int r=0; r<nRegionsY; r++){
+
+        int y0 = flowH * r / nRegionsY, y1 = flowH * (r+1) / nRegionsY;
+
+        for (int c=0; c<nRegionsX; c++){
+
+            int n = (y1 - y0) * (regionX[c+1] - regionX[c]);
+            int i = r * nRegionsX + c;
+
+            if (n > 0){
+                regionAvgs[i] = Point2f(regionSums[i*2] / n, regionSums[i*2+1] / n);
+            }
+        }
+    }
+
+    int nTotal = flowW * flowH;
+    avg = Point2f(totalX / nTotal, totalY / nTotal);
+    avgMag = totalMag / nTotal;
+}
+
+
+//--------------------------------------------------------------
+// GETTERS
+//--------------------------------------------------------------
+
+const vector<int>& FlowStats::getMagnitudeHistogram() const{
+    return magHist;
+}
+
+const vector<float>& FlowStats::getAngleHistogram() const{
+    return angleHist;
+}
+
+const vector<Point2f>& FlowStats::getRegionAverages() const{
+    return regionAvgs;
+}
+
+Point2f FlowStats::getAverage() const{
+    return avg;
+}
+
+float FlowStats::getAverageMagnitude() const{
+    return avgMag;
+}
+
+int FlowStats::getNMagBins() const{
+    return nMagBins;
+}
+
+int FlowStats::getNAngleBins() const{
+    return nAngleBins;
+}
+
+float FlowStats::getMaxMag() const{
+    return maxMag;
+}
+
+int FlowStats::getNRegionsX() const{
+    return nRegionsX;
+}
+
+int FlowStats::getNRegionsY() const{
+    return nRegionsY;
+}
+
+ofRectangle FlowStats::getRegion(int n) const{
+
+    int r = n / nRegionsX, c = n % nRegionsX;
+    int y0 = flowH * r / nRegionsY, y1 = flowH * (r+1) / nRegionsY;
+
+    return ofRectangle(regionX[c], y0, regionX[c+1] - regionX[c], y1 - y0);
+}
+
+
+//--------------------------------------------------------------
+// DRAW HISTOGRAMS
+// bar charts, each scaled to its own max
+//--------------------------------------------------------------
+
+void FlowStats::drawHistograms(float x, float y, float w, float h) const{
+
+    ofPushMatrix();
+    ofTranslate(x,y);
+
+    ofPushStyle();
+    ofFill();
+
+    float halfH = h * 0.5;
+
+    int magMax = 1;
+    for (int i=0; i<nMagBins; i++) magMax = max(magMax, magHist[i]);
+
+    float angleMax = 1e-6;
+    for (int i=0; i<nAngleBins; i++) angleMax = max(angleMax, angleHist[i]);
+
+    ofSetColor(255,255,0);
+    for (int i=0; i<nMagBins; i++){
+        float barH = ofMap(magHist[i], 0,magMax, 0,halfH-10);
+        ofDrawRectangle(w * i / nMagBins, halfH-10 - barH, w / nMagBins - 1, barH);
+    }
+
+    ofSetColor(0,255,255);
+    for (int i=0; i<nAngleBins; i++){
+        float barH = ofMap(angleHist[i], 0,angleMax, 0,halfH-10);
+        ofDrawRectangle(w * i / nAngleBins, h - barH, w / nAngleBins - 1, barH);
+    }
+
+    ofPopStyle();
+    ofPopMatrix();
+
+    ofDrawBitmapStringHighlight("magnitude 0-" + ofToString(maxMag) + "px", x, y);
+    ofDrawBitmapStringHighlight("direction (mag weighted)", x, y + halfH);
+}
@@ -0,0 +1,85 @@
+//
+//  FlowStats.hpp
+//  optFlowTest
+//
+
+#pragma once
+#include "ofMain.h"
+
+#include "ofxOpenCv.h"
+#include "ofxCv.h"
+
+using namespace cv;
+using namespace ofxCv;
+
+
+// angle of (x,y) in radians, 0 to TWO_PI
+// polynomial approximation (max error ~0.0015 rad) with no library calls,
+// the branches turn into selects so loops using it still vectorize
+
+inline float flowAngle(float x, float y){
+
+    float ax = fabsf(x), ay = fabsf(y);
+    float a = min(ax, ay) / (max(ax, ay) + 1e-10f);
+    float s = a * a;
+    float r = ((-0.0464964749f * s + 0.15931422f) * s - 0.327622764f) * s * a + a;
+
+    r = (ay > ax) ? 1.57079637f - r : r;
+    r = (x < 0) ? 3.14159274f - r : r;
+    r = (y < 0) ? 6.28318548f - r : r;
+
+    return r;
+}
+
+
+class FlowStats {
+
+public:
+
+    FlowStats();
+
+    void setup(int _nMagBins = 16, float _maxMag = 8, int _nAngleBins = 16, int _nRegionsX = 4, int _nRegionsY = 4);
+    // magnitude bins cover 0 to maxMag px/frame (last bin also holds anything faster), maxMag > 0
+    // regions split the frame into an nRegionsX * nRegionsY grid
+
+    void run(const Mat& flow);
+    // single pass over a CV_32FC2 flow field (i.e. FlowFarneback::getFlow())
+    // fills every statistic below at once, no allocation after the first frame.
+    // NaN / inf vectors are left out of the histograms and count as no motion in the averages
+
+    const vector<int>& getMagnitudeHistogram() const; // # of vectors per magnitude bin
+    const vector<float>& getAngleHistogram() const; // summed magnitude per direction bin (bin 0 starts at +x, clockwise on screen)
+    const vector<Point2f>& getRegionAverages() const; // average flow per region, row by row
+    Point2f getAverage() const; // average flow of the whole frame (same as FlowFarneback::getAverageFlow())
+    float getAverageMagnitude() const;
+
+    int getNMagBins() const;
+    int getNAngleBins() const;
+    float getMaxMag() const;
+    int getNRegionsX() const;
+    int getNRegionsY() const;
+    ofRectangle getRegion(int n) const; // region bounds in flow coords, from the last run()
+
+    void drawHistograms(float x, float y, float w, float h) const;
+    // magnitude histogram on top, direction histogram below
+
+private:
+
+    int nMagBins = 16, nAngleBins = 16, nRegionsX = 4, nRegionsY = 4;
+    float maxMag = 8;
+    int flowW = 0, flowH = 0;
+
+    // per row scratch, sized to the flow width
+    vector<float> rowMag;
+    vector<int> rowMagBin, rowAngleBin;
+    vector<int> regionX; // region column boundaries (nRegionsX + 1)
+
+    vector<int> magHist;
+    vector<float> angleHist;
+    vector<Point2f> regionAvgs;
+    vector<double> regionSums; // x,y per region
+
+    Point2f avg;
+    float avgMag = 0;
+
+};
@@ -0,0 +1,302 @@
+//
+//  FlowSweep.cpp
+//  shared
+//
+
+#include "FlowSweep.hpp"
+
+
+FlowSweep::FlowSweep(){
+
+    setReference(FlowSettings());
+}
+
+
+//--------------------------------------------------------------
+// CONFIGS
+//--------------------------------------------------------------
+
+void FlowSweep::setReference(const FlowSettings& settings){
+
+    reference.reset(new Config());
+    reference->result.settings = settings;
+}
+
+
+void FlowSweep::addConfig(const FlowSettings& settings){
+
+    configs.push_back(unique_ptr<Config>(new Config()));
+    configs.back()->result.settings = settings;
+}
+
+
+void FlowSweep::addGrid(const vector<float>& pyrScales, const vector<int>& levels, const vector<int>& iterations,
+                        const vector<int>& polyNs, const vector<float>& polySigmas, const vector<int>& winSizes){
+
+    const FlowSettings& base = reference->result.settings;
+
+    vector<float> p = pyrScales.empty() ? vector<float>(1, base.pyrScale) : pyrScales;
+    vector<int> l = levels.empty() ? vector<int>(1, base.levels) : levels;
+    vector<int> it = iterations.empty() ? vector<int>(1, base.iterations) : iterations;
+    vector<int> n = polyNs.empty() ? vector<int>(1, base.polyN) : polyNs;
+    vector<float> s = polySigmas.empty() ? vector<float>(1, base.polySigma) : polySigmas;
+    vector<int> w = winSizes.empty() ? vector<int>(1, base.winSize) : winSizes;
+
+    for (float pyrScale : p){
+        for (int level : l){
+            for (int iteration : it){
+                for (int polyN : n){
+                    for (float polySigma : s){
+                        for (int winSize : w){
+                            FlowSettings settings = base;
+                            settings.pyrScale = pyrScale;
+                            settings.levels = level;
+                            settings.iterations = iteration;
+                            settings.polyN = polyN;
+                            settings.polySigma = polySigma;
+                            settings.winSize = winSize;
+                            addConfig(settings);
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+
+void FlowSweep::clear(){
+
+    configs.clear();
+    results.clear();
+}
+
+
+//--------------------------------------------------------------
+// RUN
+//--------------------------------------------------------------
+
+bool FlowSweep::run(const string& videoPath, int startFrame, int endFrame, float scale){
+
+    VideoCapture capture(ofToDataPath(videoPath, true));
+    if (!capture.isOpened()){
+        ofLogError("FlowSweep") << "couldn't open " << videoPath;
+        return false;
+    }
+
+    // skip to startFrame by decoding, a POS_FRAMES seek isn't exact with every codec (ffmpeg + MP4)
+    // and the sweep's frames should be the ones asked for
+
+    int frame = 0;
+    while (frame < startFrame && capture.grab()) frame++;
+    Mat decoded, gray;
+
+    return run([&](Mat& out){
+        if ((endFrame >= 0 && frame >= endFrame) || !capture.read(decoded)) return false;
+        frame++;
+
+        if (scale == 1 || scale <= 0){
+            cvtColor(decoded, out, CV_BGR2GRAY);
+        } else {
+            cvtColor(decoded, gray, CV_BGR2GRAY);
+            resize(gray, out, cv::Size(), scale, scale, INTER_AREA);
+        }
+        return true;
+    });
+}
+
+
+bool FlowSweep::run(const FrameCache& cache, int startFrame, int endFrame, float scale){
+
+    if (!cache.isOpen()){
+        ofLogError("FlowSweep") << "frame cache isn't open";
+        return false;
+    }
+
+    int frame = max(startFrame, 0);
+    if (endFrame < 0 || endFrame > cache.getNumFrames()) endFrame = cache.getNumFrames();
+
+    return run([&](Mat& out){
+        if (frame >= endFrame) return false;
+
+        if (scale == 1 || scale <= 0) out = cache.getFrame(frame);
+        else resize(cache.getFrame(frame), out, cv::Size(), scale, scale, INTER_AREA);
+
+        frame++;
+        return true;
+    });
+}
+
+
+bool FlowSweep::run(const function<bool(Mat&)>& readFrame){
+
+    uint64_t startTime = ofGetElapsedTimeMillis();
+
+    // the reference is just one more config to run, it's first so log() etc. can skip it
+
+    vector<Config*> all(1, reference.get());
+    for (auto& config : configs) all.push_back(config.get());
+
+    for (Config* config : all){
+        config->result.settings.apply(config->flow);
+        config->flow.resetFlow();
+        config->result.frameMs.clear();
+        config->result.frameError.clear();
+        config->closeSum = 0;
+    }
+
+    Mat current;
+    if (!readFrame(current)){
+        ofLogError("FlowSweep") << "no frames to sweep over";
+        return false;
+    }
+
+    int nFrames = 0;
+
+    while (!current.empty()){
+
+        // every config's flow on this frame, the next frame decoding next to them.
+        // next is a new Mat every frame, the decoder never writes into a frame a flow still holds
+
+        Mat next;
+        bool bFirst = nFrames == 0;
+
+        TaskGroup group;
+
+        group.run([&readFrame, &next]{
+            if (!readFrame(next)) next = Mat();
+        });
+
+        for (Config* config : all){
+            group.run([config, &current, bFirst]{
+                uint64_t start = ofGetElapsedTimeMicros();
+                config->flow.calcOpticalFlow(current);
+                if (!bFirst) config->result.frameMs.push_back((ofGetElapsedTimeMicros() - start) / 1000.0);
+            });
+        }
+
+        group.wait();
+
+        // then every config against the reference, once its flow is done too
+
+        if (!bFirst){
+            const Mat& referenceFlow = reference->flow.getFlow();
+
+            TaskScheduler::get().parallelFor(0, all.size(), 1, [&](int begin, int end){
+                for (int i=begin; i<end; i++){
+                    compare(*all[i], referenceFlow);
+                }
+            });
+        }
+
+        current = next;
+        nFrames++;
+    }
+
+    results.clear();
+    for (Config* config : all){
+        summarize(*config);
+        if (config != reference.get()) results.push_back(config->result);
+    }
+
+    ofLogNotice("FlowSweep") << configs.size() << " configs + reference over " << nFrames << " frames took "
+    << ofGetElapsedTimeMillis() - startTime << " ms";
+
+    return true;
+}
+
+
+void FlowSweep::compare(Config& config, const Mat& referenceFlow){
+
+    // endpoint error: length of the difference between the two flow vectors, px
+
+    const Mat& flow = config.flow.getFlow();
+
+    double errorSum = 0;
+    int nClose = 0;
+
+    for (int y=0; y<flow.rows; y++){
+
+        const Point2f* a = flow.ptr<Point2f>(y);
+        const Point2f* b = referenceFlow.ptr<Point2f>(y);
+
+        for (int x=0; x<flow.cols; x++){
+            float dx = a[x].x - b[x].x;
+            float dy = a[x].y - b[x].y;
+            float error = sqrtf(dx * dx + dy * dy);
+            errorSum += error;
+            nClose += error <= 1;
+        }
+    }
+
+    int n = max(flow.rows * flow.cols, 1);
+    config.result.frameError.push_back(errorSum / n);
+    config.closeSum += (double)nClose / n;
+}
+
+
+void FlowSweep::summarize(Config& config){
+
+    ConfigResult& result = config.result;
+
+    result.medianMs = result.meanMs = result.meanError = result.closeRatio = 0;
+
+    if (!result.frameMs.empty()){
+        vector<double> sorted = result.frameMs;
+        sort(sorted.begin(), sorted.end());
+        result.medianMs = sorted[sorted.size() / 2];
+        result.meanMs = accumulate(sorted.begin(), sorted.end(), 0.0) / sorted.size();
+    }
+
+    if (!result.frameError.empty()){
+        result.meanError = accumulate(result.frameError.begin(), result.frameError.end(), 0.0) / result.frameError.size();
+        result.closeRatio = config.closeSum / result.frameError.size();
+    }
+}
+
+
+//--------------------------------------------------------------
+// RESULTS
+//--------------------------------------------------------------
+
+const FlowSweep::ConfigResult& FlowSweep::getReferenceResult() const{
+
+    return reference->result;
+}
+
+
+const vector<FlowSweep::ConfigResult>& FlowSweep::getResults() const{
+
+    return results;
+}
+
+
+int FlowSweep::getCheapest(float maxError) const{
+
+    int cheapest = -1;
+
+    for (int i=0; i<results.size(); i++){
+        if (results[i].meanError <= maxError && (cheapest < 0 || results[i].medianMs < results[cheapest].medianMs)){
+            cheapest = i;
+        }
+    }
+
+    return cheapest;
+}
+
+
+void FlowSweep::log() const{
+
+    const ConfigResult& ref = reference->result;
+    ofLogNotice("FlowSweep") << "reference: " << ofToString(ref.medianMs, 2) << " ms (" << ref.settings.toString() << ")";
+
+    vector<int> order(results.size());
+    for (int i=0; i<order.size(); i++) order[i] = i;
+    sort(order.begin(), order.end(), [this](int a, int b){ return results[a].medianMs < results[b].medianMs; });
+
+    for (int i : order){
+        const ConfigResult& result = results[i];
+        ofLogNotice("FlowSweep") << ofToString(result.medianMs, 2) << " ms, error " << ofToString(result.meanError, 3) << " px, "
+        << ofToString(result.closeRatio * 100, 1) << "% within 1 px (" << result.settings.toString() << ")";
+    }
+}
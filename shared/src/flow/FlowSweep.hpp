@@ -0,0 +1,81 @@
+//
+//  FlowSweep.hpp
+//  shared
+//
+
+#pragma once
+#include "ofMain.h"
+
+#include "ofxOpenCv.h"
+#include "ofxCv.h"
+
+#include "FlowSettings.hpp"
+#include "TaskScheduler.hpp"
+#include "FrameCache.hpp"
+
+using namespace cv;
+using namespace ofxCv;
+
+
+// headless sweep over Farneback settings, what optFlowTest's gui does one combination at a time:
+// every frame is decoded once and handed to N FlowFarnebacks (one per config) running as parallel tasks,
+// while the next frame decodes. each config's time per frame is recorded, and its flow compared
+// against a reference config's flow of the same frame (endpoint error, share of vectors within 1 px),
+// so the cheapest settings that are still close enough to the reference can be picked with getCheapest().
+//
+// configs run side by side, so their times are with the other configs competing for the cores:
+// good for comparing configs with each other, a single FlowFarneback on its own runs faster
+
+class FlowSweep {
+
+public:
+
+    struct ConfigResult {
+        FlowSettings settings;
+        vector<double> frameMs; // time of each frame's flow (not the first frame, it only sets the previous frame)
+        vector<float> frameError; // mean endpoint error vs the reference's flow, px, per frame
+        double medianMs = 0, meanMs = 0;
+        double meanError = 0; // over all frames, px
+        double closeRatio = 0; // share of flow vectors within 1 px of the reference's
+    };
+
+    FlowSweep();
+
+    void setReference(const FlowSettings& settings); // default: FlowSettings() (optFlowTest's defaults)
+    void addConfig(const FlowSettings& settings);
+    void addGrid(const vector<float>& pyrScales, const vector<int>& levels, const vector<int>& iterations,
+                 const vector<int>& polyNs, const vector<float>& polySigmas, const vector<int>& winSizes);
+    // every combination of the values, an empty list keeps the reference's value for that parameter
+    void clear(); // configs and results, not the reference
+
+    bool run(const string& videoPath, int startFrame = 0, int endFrame = -1, float scale = 1);
+    // frames startFrame to endFrame (exclusive, -1 = to the end) of a clip, decoded with cv::VideoCapture.
+    // scale < 1 downscales them before the flow. frames before startFrame are decoded too (no seeking)
+    bool run(const FrameCache& cache, int startFrame = 0, int endFrame = -1, float scale = 1);
+    // same, frames from a FrameCache (on top of the cache's own scale)
+
+    const ConfigResult& getReferenceResult() const;
+    const vector<ConfigResult>& getResults() const; // the added configs, in the order they were added
+    int getCheapest(float maxError) const;
+    // config with the lowest median time and a mean endpoint error <= maxError, -1 if none is
+
+    void log() const; // one line per config, sorted by time
+
+private:
+
+    struct Config {
+        FlowFarneback flow;
+        ConfigResult result;
+        double closeSum = 0; // closeRatio summed over frames
+    };
+
+    bool run(const function<bool(Mat&)>& readFrame);
+    // readFrame: next gray frame, false at the end. called on a task, one frame ahead of the flow
+    void compare(Config& config, const Mat& referenceFlow);
+    static void summarize(Config& config);
+
+    unique_ptr<Config> reference;
+    vector<unique_ptr<Config>> configs;
+    vector<ConfigResult> results; // copied out of configs at the end of run()
+
+};
@@ -0,0 +1,111 @@
+//
+//  SceneCutDetector.cpp
+//  optFlowTest
+//
+
+#include "SceneCutDetector.hpp"
+
+
+SceneCutDetector::SceneCutDetector(){
+    setup();
+}
+
+void SceneCutDetector::setup(float _threshold, float _ratio, int _minShotLength, int _thumbW, int _thumbH, int _nBins){
+
+    threshold = _threshold;
+    ratio = _ratio;
+    minShotLength = _minShotLength;
+    thumbW = _thumbW;
+    thumbH = _thumbH;
+    nBins = ofClamp(_nBins, 1, 256);
+
+    hist.assign(nBins, 0);
+    prevHist.assign(nBins, 0);
+
+    reset();
+}
+
+void SceneCutDetector::reset(){
+
+    hasPrev = false;
+    framesSinceCut = 0;
+    diff = avgDiff = 0;
+}
+
+
+//--------------------------------------------------------------
+// UPDATE
+// cost is independent of the video size after the resize:
+// a 64x36 thumbnail is ~2300 pixels to count
+//--------------------------------------------------------------
+
+bool SceneCutDetector::update(const Mat& frame){
+
+    if (frame.empty()) return false;
+
+    // downsample (INTER_AREA averages, so noise and grain mostly cancel out)
+
+    resize(frame, thumb, cv::Size(thumbW, thumbH), 0, 0, INTER_AREA);
+
+    const Mat* gray = &thumb;
+    if (thumb.channels() == 3){
+        cvtColor(thumb, thumbGray, CV_RGB2GRAY);
+        gray = &thumbGray;
+    } else if (thumb.channels() == 4){
+        cvtColor(thumb, thumbGray, CV_RGBA2GRAY);
+        gray = &thumbGray;
+    }
+
+
+    // normalized intensity histogram
+
+    std::fill(hist.begin(), hist.end(), 0.f);
+
+    const float norm = 1.f / (thumbW * thumbH);
+
+    for (int y=0; y<gray->rows; y++){
+        const uchar* row = gray->ptr<uchar>(y);
+        for (int x=0; x<gray->cols; x++){
+            hist[row[x] * nBins >> 8] += norm;
+        }
+    }
+
+
+    // compare to previous frame
+
+    bool bCut = false;
+
+    if (hasPrev){
+
+        diff = 0;
+        for (int i=0; i<nBins; i++){
+            diff += fabsf(hist[i] - prevHist[i]);
+        }
+        diff *= 0.5; // 0 = identical, 1 = no overlap
+
+        framesSinceCut++;
+
+        if (framesSinceCut >= minShotLength && diff > threshold && diff > avgDiff * ratio){
+
+            bCut = true;
+            framesSinceCut = 0;
+
+        } else {
+
+            avgDiff = ofLerp(avgDiff, diff, 0.1); // cuts don't count toward the average
+        }
+    }
+
+    hist.swap(prevHist);
+    hasPrev = true;
+
+    return bCut;
+}
+
+float SceneCutDetector::getDifference() const{
+    return diff;
+}
+
+float SceneCutDetector::getAverageDifference() const{
+    return avgDiff;
+}
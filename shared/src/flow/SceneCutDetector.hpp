@@ -0,0 +1,66 @@
+//
+//  SceneCutDetector.hpp
+//  optFlowTest
+//
+
+#pragma once
+#include "ofMain.h"
+
+#include "ofxOpenCv.h"
+#include "ofxCv.h"
+
+using namespace cv;
+using namespace ofxCv;
+
+
+// motion summary of one shot (between two cuts)
+
+struct ShotSummary {
+
+    int startFrame = 0, endFrame = 0; // end is exclusive
+    Point2f meanFlow = Point2f(0,0), flowStdDev = Point2f(0,0);
+    float meanMagnitude = 0;
+    Point2f cameraTravel = Point2f(0,0); // summed camera translation over the shot
+    float meanZoom = 1;
+
+};
+
+
+// detects hard cuts from the intensity histogram of a small thumbnail of each frame
+// a cut is a big jump in histogram difference, both in absolute terms
+// and compared to the recent average difference (so fast pans don't trigger it)
+
+class SceneCutDetector {
+
+public:
+
+    SceneCutDetector();
+
+    void setup(float _threshold = 0.35, float _ratio = 4, int _minShotLength = 8,
+               int _thumbW = 64, int _thumbH = 36, int _nBins = 32);
+    // threshold = min histogram difference for a cut, 0-1 (half the L1 distance of normalized histograms)
+    // ratio = difference must also be this many times the recent average
+    // minShotLength = frames after a cut before another can be detected (flashes, dissolves)
+
+    bool update(const Mat& frame);
+    // frame can be grayscale or RGB, any size. returns true if frame starts a new shot
+
+    void reset(); // forget the previous frame (i.e. when the video restarts)
+
+    float getDifference() const; // histogram difference of the last frame
+    float getAverageDifference() const;
+
+private:
+
+    float threshold = 0.35, ratio = 4;
+    int minShotLength = 8;
+    int thumbW = 64, thumbH = 36, nBins = 32;
+
+    Mat thumb, thumbGray; // reused every frame
+    vector<float> hist, prevHist;
+    bool hasPrev = false;
+    int framesSinceCut = 0;
+
+    float diff = 0, avgDiff = 0;
+
+};
@@ -0,0 +1,70 @@
+//
+//  HistogramCounter.hpp
+//  griddedHistogram
+//
+
+#pragma once
+#include "ofMain.h"
+#include "ofxOpenCv.h"
+#include "ofxCv.h"
+
+using namespace cv;
+using namespace ofxCv;
+
+
+// integer histogram of a (single-channel) region, what Histogrid gets from calcHist + float output
+// when all it does is count. picked at compile time by pixel type and bin count, values 0-255 go in
+// NBins even bins (same bins as calcHist with range {0, 256}), anything above 255 isn't counted.
+//
+// counts go into 4 sub-histograms, pixel i into sub-histogram i % 4, summed at the end:
+// runs of the same value (flat areas, the common case) would otherwise increment the same counter
+// back to back, each increment waiting on the previous one's store
+
+template<typename Pixel, int NBins>
+struct HistogramCounter {
+
+    static_assert(std::is_integral<Pixel>::value, "HistogramCounter counts integer pixels");
+    static_assert(NBins > 0 && NBins <= 256, "HistogramCounter bins split 0-255");
+
+    static void count(const Mat& region, uint32_t* counts){
+        // counts: NBins, overwritten
+
+        uint32_t sub[4][NBins];
+        memset(sub, 0, sizeof(sub));
+
+        for (int y=0; y<region.rows; y++){
+
+            const Pixel* row = region.ptr<Pixel>(y);
+            int x = 0;
+
+            for (; x + 4 <= region.cols; x += 4){
+                add(sub[0], row[x]);
+                add(sub[1], row[x+1]);
+                add(sub[2], row[x+2]);
+                add(sub[3], row[x+3]);
+            }
+            for (; x < region.cols; x++){
+                add(sub[0], row[x]);
+            }
+        }
+
+        for (int i=0; i<NBins; i++){
+            counts[i] = sub[0][i] + sub[1][i] + sub[2][i] + sub[3][i];
+        }
+    }
+
+private:
+
+    static inline void add(uint32_t* hist, Pixel value){
+        if (value <= 255) hist[value * NBins >> 8]++; // constant bin count: multiply + shift, no division
+    }
+
+};
+
+
+// 8-bit pixels with 256 bins: the pixel is the bin
+
+template<>
+inline void HistogramCounter<uchar, 256>::add(uint32_t* hist, uchar value){
+    hist[value]++;
+}
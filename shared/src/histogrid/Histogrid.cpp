@@ -0,0 +1,340 @@
+//
+//  Histogrid.cpp
+//  griddedHistogram
+//
+//  Created by Tyler on 3/31/16.
+//
+//
+
+#include "Histogrid.hpp"
+
+
+Histogrid::Histogrid(){
+    
+}
+
+
+Histogrid::Histogrid(ofImage& _img, int _nDivsX, int _nDivsY, int _nBins){
+    
+    img = &_img;
+    
+    nDivsX = _nDivsX;
+    nDivsY = _nDivsY;
+    nBins = _nBins;
+    
+}
+
+
+Histogrid::Histogrid(int _nDivsX, int _nDivsY, int _nBins){
+    
+    nDivsX = _nDivsX;
+    nDivsY = _nDivsY;
+    nBins = _nBins;
+    
+}
+
+
+void Histogrid::run(){
+    
+    if (!img){ // made without an image (or default constructed), only run(Mat) has something to count
+        ofLogError("Histogrid") << "run() without an image, use run(Mat)";
+        return;
+    }
+    
+    // grayscale for intensity
+    // converted into gray's own buffer (img isn't changed), only again after imgChanged()
+    
+    calcHistograms(gray.get(img->getPixels(), imgGeneration));
+}
+
+
+void Histogrid::run(const Mat& src){
+    
+    imgGeneration++; // taken to be a new frame every time
+    calcHistograms(gray.get(src, imgGeneration));
+}
+
+
+void Histogrid::calcHistograms(const Mat& imgMat){
+    
+    // grid cells
+    
+    rects.clear();
+    rects.reserve(nDivsX * nDivsY);
+    
+    cellW = imgMat.cols / nDivsX;
+    cellH = imgMat.rows / nDivsY;
+    
+    for (int r=0; r<nDivsY; r++){ // x
+        for (int c=0; c<nDivsX; c++){ // y
+            
+            int x = imgMat.cols / nDivsX * c; // x
+            int y = imgMat.rows / nDivsY * r; // y
+            int w = imgMat.cols / nDivsX; // width
+            int h = imgMat.rows / nDivsY; // height
+            
+            // save to rects for future reference
+            rects.push_back(ofRectangle( x,y, w,h ));
+        }
+    }
+    
+    counts.resize(rects.size() * nBins);
+    histograms.resize(rects.size());
+    bNormalized.assign(rects.size(), false); // normalized again on access
+    
+    
+    // lazy: just the bin of every pixel for now, in binned (the source can change before a cell is counted)
+    
+    if (bLazy && imgMat.type() == CV_8UC1 && nBins <= 256){
+        
+        if (nBins == 256){
+            imgMat.copyTo(binned); // the pixel is the bin
+        } else {
+            Mat lut(1, 256, CV_8UC1);
+            for (int i=0; i<256; i++){
+                lut.at<uchar>(i) = i * nBins >> 8; // same bins as HistogramCounter / calcHist
+            }
+            LUT(imgMat, lut, binned);
+        }
+        
+        bCounted.assign(rects.size(), false);
+        return;
+    }
+    
+    binned.release();
+    bCounted.assign(rects.size(), true);
+    
+    
+    // count every cell
+    // cells are independent, so they're spread over the TaskScheduler's threads
+    
+    TaskScheduler::get().parallelFor(0, rects.size(), 1, [&](int begin, int end){
+        
+        for (int n=begin; n<end; n++){
+            
+            // histogram of just the cell's part of the image
+            // (a view, same counts as masking the whole image with the cell's rectangle)
+            Mat cell = imgMat(cv::Rect(rects[n].x, rects[n].y, rects[n].width, rects[n].height));
+            
+            countCell(cell, &counts[n * nBins]);
+        }
+    });
+    
+}
+
+
+void Histogrid::countCell(const Mat& cell, uint32_t* cellCounts) const{
+    
+    // integer counting for the bin counts it's built for, the bin count is a template parameter
+    
+    if (cell.type() == CV_8UC1 && !bUseCalcHist){
+        switch (nBins){
+            case 256: HistogramCounter<uchar, 256>::count(cell, cellCounts); return;
+            case 128: HistogramCounter<uchar, 128>::count(cell, cellCounts); return;
+            case 64: HistogramCounter<uchar, 64>::count(cell, cellCounts); return;
+            case 32: HistogramCounter<uchar, 32>::count(cell, cellCounts); return;
+            case 16: HistogramCounter<uchar, 16>::count(cell, cellCounts); return;
+        }
+    }
+    if (cell.type() == CV_16UC1 && nBins == 256 && !bUseCalcHist){
+        HistogramCounter<ushort, 256>::count(cell, cellCounts);
+        return;
+    }
+    
+    // anything else
+    
+    Mat hist;
+    int histSize = nBins; // calcHist wants non-const
+    float range[] = { 0, 256 }; // histogram range, upper bound exclusive
+    const float* histRange = { range }; // another range? cv weirdness
+    
+    calcHist(&cell, 1, 0, Mat(), hist, 1, &histSize, &histRange, true, false);
+    
+    for (int i=0; i<nBins; i++){
+        cellCounts[i] = cvRound(hist.at<float>(i));
+    }
+}
+
+
+void Histogrid::countBinnedCell(int n) const{
+    
+    // bins are already pixel values in binned, so it's always the 256 bin counter
+    
+    uint32_t binCounts[256];
+    HistogramCounter<uchar, 256>::count(binned(cv::Rect(rects[n].x, rects[n].y, rects[n].width, rects[n].height)), binCounts);
+    
+    copy(binCounts, binCounts + nBins, &counts[n * nBins]);
+    bCounted[n] = true;
+}
+
+
+void Histogrid::normalizeCell(int n) const{
+    
+    // counts to 0-255, min to max (what normalize() with NORM_MINMAX did on the float histogram)
+    
+    const uint32_t* cellCounts = &counts[n * nBins];
+    uint32_t minCount = *min_element(cellCounts, cellCounts + nBins);
+    uint32_t maxCount = *max_element(cellCounts, cellCounts + nBins);
+    float scale = maxCount > minCount ? 255.f / (maxCount - minCount) : 0; // all 0 if every bin is the same
+    
+    histograms[n].resize(nBins);
+    for (int i=0; i<nBins; i++){
+        histograms[n][i] = (cellCounts[i] - minCount) * scale;
+    }
+    
+    bNormalized[n] = true;
+}
+
+void Histogrid::draw(int n, ofColor color){
+    const Mat& imgMat = gray.get();
+    draw(n,0,0,imgMat.cols,imgMat.rows, color);
+    // draw at (0,0) and image size
+}
+
+void Histogrid::draw(int n, float x, float y, float w, float h, ofColor color){
+    
+    const vector<float>& histogram = getHistogram(n);
+    
+    ofPushMatrix();
+    ofTranslate(x,y);
+    
+    ofPushStyle();
+    ofSetLineWidth(1);
+    ofFill();
+    ofSetColor(color);
+    
+    for (int i=0; i<nBins-1; i++){
+        
+        ofVec2f pt1;
+        pt1.x= ofMap(i, 0,nBins, 0,w);
+        pt1.y= ofMap(histogram[i], 0,255, h,0);
+        
+        ofVec2f pt2;
+        pt2.x= ofMap(i+1, 0,nBins, 0,w);
+        pt2.y= ofMap(histogram[i+1], 0,255, h, 0);
+        
+        ofDrawLine(pt1,pt2); // line chart histogram
+        
+    }
+                   
+    ofPopStyle();
+    ofPopMatrix();
+    
+}
+
+
+void Histogrid::imgChanged(){
+    
+    imgGeneration++;
+}
+
+
+const vector<vector<float>>& Histogrid::getHistograms() const{
+    
+    // every cell, so any not counted yet (lazy mode) are counted in parallel first
+    
+    TaskScheduler::get().parallelFor(0, bCounted.size(), 1, [this](int begin, int end){
+        for (int n=begin; n<end; n++){
+            if (!bCounted[n]) countBinnedCell(n);
+        }
+    });
+    
+    for (int n=0; n<histograms.size(); n++){
+        if (!bNormalized[n]) normalizeCell(n);
+    }
+    
+    return histograms; // return all histograms
+}
+
+const vector<float>& Histogrid::getHistogram(int n) const{
+    
+    if (!bCounted[n]) countBinnedCell(n);
+    if (!bNormalized[n]) normalizeCell(n);
+    
+    return histograms[n]; // return specific histogram
+}
+
+const uint32_t* Histogrid::getCounts(int n) const{
+    
+    if (!bCounted[n]) countBinnedCell(n);
+    
+    return &counts[n * nBins];
+}
+
+void Histogrid::setUseCalcHist(bool b){
+    
+    bUseCalcHist = b;
+}
+
+void Histogrid::setLazy(bool b){
+    
+    bLazy = b; // from the next run()
+}
+
+int Histogrid::getNDivsX(){
+    
+    return nDivsX;
+}
+
+int Histogrid::getNDivsY(){
+    
+    return nDivsY;
+}
+
+int Histogrid::getNBins(){
+    
+    return nBins;
+}
+
+const vector<ofRectangle>& Histogrid::getRectangles() const{
+    return rects;
+}
+
+
+int Histogrid::getCellAt(float x, float y) const{
+    
+    // every cell is cellW x cellH from (0,0), so the cell is just the point divided down
+    // (the leftover pixels right / below the last cells aren't in any cell)
+    
+    if (cellW <= 0 || cellH <= 0 || x < 0 || y < 0) return -1;
+    
+    int c = x / cellW;
+    int r = y / cellH;
+    
+    if (c >= nDivsX || r >= nDivsY) return -1;
+    
+    return r * nDivsX + c;
+}
+
+vector<int> Histogrid::getCellsIn(const ofRectangle& rect) const{
+    
+    vector<int> cells;
+    
+    if (cellW <= 0 || cellH <= 0) return cells;
+    
+    ofRectangle r = rect.getStandardized(); // positive width / height
+    
+    // first and last column / row touched, a far edge exactly on a cell boundary doesn't reach into the next cell
+    
+    int c0 = floor(r.x / cellW);
+    int r0 = floor(r.y / cellH);
+    int c1 = r.width > 0 ? ceil((r.x + r.width) / cellW) - 1 : c0;
+    int r1 = r.height > 0 ? ceil((r.y + r.height) / cellH) - 1 : r0;
+    
+    c0 = max(c0, 0);
+    r0 = max(r0, 0);
+    c1 = min(c1, nDivsX - 1);
+    r1 = min(r1, nDivsY - 1);
+    
+    if (c0 > c1 || r0 > r1) return cells; // outside the grid
+    
+    cells.reserve((c1 - c0 + 1) * (r1 - r0 + 1));
+    
+    for (int row=r0; row<=r1; row++){
+        for (int col=c0; col<=c1; col++){
+            cells.push_back(row * nDivsX + col);
+        }
+    }
+    
+    return cells;
+}
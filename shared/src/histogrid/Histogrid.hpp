@@ -0,0 +1,85 @@
+//
+//  Histogrid.hpp
+//  griddedHistogram
+//
+//  Created by Tyler on 3/31/16.
+//
+//
+
+#pragma once
+#include "ofMain.h"
+
+#include "ofxOpenCv.h"
+#include "ofxCv.h"
+
+#include "GrayscaleCache.hpp"
+#include "TaskScheduler.hpp"
+#include "HistogramCounter.hpp"
+
+using namespace cv;
+using namespace ofxCv;
+
+// grid of intensity histograms over an image, one per cell.
+// run() only counts: 8-bit images with 256, 128, 64, 32 or 16 bins (and 16-bit ones with 256) go through HistogramCounter
+// (integer counts, no float histogram), anything else through calcHist. the 0-255 normalized
+// histograms are made from the counts on first access, so cells nobody looks at are never normalized
+//
+// lazy mode (setLazy(true), for 8-bit images) goes further: run() makes one pass over the pixels,
+// writing each pixel's bin into a buffer of its own, and a cell is only counted from that the first time
+// it's asked for. for interactive use on fine grids, where only the cell under the mouse is ever shown.
+// cells are counted / normalized from the const getters, so those aren't safe to call from several threads at once
+
+class Histogrid {
+    
+public:
+    
+    Histogrid();
+    Histogrid(ofImage& _img, int _nDivsX = 10, int _nDivsY = 10, int _nBins = 256);
+    Histogrid(int _nDivsX, int _nDivsY, int _nBins = 256); // no image, for run(Mat)
+    
+    void run(); // histograms of the image, logs an error if there isn't one
+    void run(const Mat& src); // histograms of a Mat instead of the image (grayscale, RGB or RGBA), converted every call
+    void imgChanged(); // call after changing the image's pixels in place, so run() converts them again
+    void draw(int n, ofColor color = ofColor::white);
+    void draw(int n, float x, float y, float w, float h, ofColor color = ofColor::white);
+    void drawMat();
+    
+    const vector<vector<float>>& getHistograms() const; // all cells normalized (min-max to 0-255)
+    const vector<float>& getHistogram(int n) const; // cell n normalized, on first access after run()
+    const uint32_t* getCounts(int n) const; // cell n's raw pixel counts, nBins of them
+    void setUseCalcHist(bool b); // calcHist for every image, to compare with the integer counting
+    void setLazy(bool b); // cells counted on first access instead of in run()
+    int getNDivsX();
+    int getNDivsY();
+    int getNBins();
+    const vector<ofRectangle>& getRectangles() const;
+    
+    int getCellAt(float x, float y) const;
+    // cell at a point (image pixels), -1 if it's outside the grid. from the grid's size, not a search through the cells
+    vector<int> getCellsIn(const ofRectangle& rect) const;
+    // cells overlapping a rectangle (image pixels), row by row. an empty rectangle gives the cell at its position
+    
+private:
+    
+    void calcHistograms(const Mat& imgMat);
+    void countCell(const Mat& cell, uint32_t* counts) const;
+    void countBinnedCell(int n) const; // from binned, lazy mode
+    void normalizeCell(int n) const;
+    
+    int nDivsX, nDivsY, nBins;
+    ofImage* img = nullptr;
+    GrayscaleCache gray; // grayscale of img (RGB / RGBA converted, single-channel used as is)
+    uint64_t imgGeneration = 0;
+    
+    bool bUseCalcHist = false;
+    bool bLazy = false;
+    
+    Mat binned; // bin of every pixel (CV_8UC1), lazy mode only
+    mutable vector<uint32_t> counts; // nBins per cell, cell after cell
+    mutable vector<uint8_t> bCounted; // per cell, since the last run()
+    mutable vector<vector<float>> histograms; // normalized from counts on access
+    mutable vector<uint8_t> bNormalized; // per cell, since the last run()
+    vector<ofRectangle> rects;
+    int cellW = 0, cellH = 0; // size of every cell, from the last run()
+    
+};
@@ -0,0 +1,348 @@
+//
+//  DescriptorCompressor.cpp
+//  SIFT_filterMatches_homography
+//
+
+#include "DescriptorCompressor.hpp"
+
+
+DescriptorCompressor::DescriptorCompressor(){
+}
+
+void DescriptorCompressor::setup(int _pcaDims, int _nSubquantizers){
+
+    nSubquantizers = max(1, _nSubquantizers);
+    pcaDims = max(nSubquantizers, _pcaDims / nSubquantizers * nSubquantizers); // round down to a multiple
+    subDims = pcaDims / nSubquantizers;
+
+    if (pcaDims != _pcaDims){
+        ofLogWarning("DescriptorCompressor") << "pcaDims rounded to " << pcaDims << " to split evenly into " << nSubquantizers;
+    }
+
+    bTrained = false;
+}
+
+
+//--------------------------------------------------------------
+// ROOTSIFT
+//--------------------------------------------------------------
+
+void DescriptorCompressor::rootSift(const Mat& src, Mat& dst){
+
+    src.convertTo(dst, CV_32F);
+
+    for (int i=0; i<dst.rows; i++){
+
+        float* row = dst.ptr<float>(i);
+
+        float total = 0;
+        for (int j=0; j<dst.cols; j++) total += fabsf(row[j]);
+
+        float norm = 1.f / (total + 1e-7f);
+        for (int j=0; j<dst.cols; j++) row[j] = sqrtf(fabsf(row[j]) * norm);
+    }
+}
+
+
+//--------------------------------------------------------------
+// TRAIN
+//--------------------------------------------------------------
+
+bool DescriptorCompressor::train(const Mat& descriptors){
+
+    if (descriptors.rows < nCentroids){
+        ofLogError("DescriptorCompressor") << "need at least " << nCentroids << " descriptors to train, got " << descriptors.rows;
+        return false;
+    }
+
+    uint64_t startTime = ofGetElapsedTimeMillis();
+
+    Mat& root = rootBuf.view(descriptors.rows, descriptors.cols, CV_32F);
+    rootSift(descriptors, root);
+
+    pca(root, Mat(), CV_PCA_DATA_AS_ROW, pcaDims);
+
+    Mat& projected = projBuf.view(descriptors.rows, pcaDims, CV_32F);
+    project(descriptors, projected);
+
+
+    // one k-means codebook per subspace
+
+    codebooks.create(nSubquantizers * nCentroids, subDims, CV_32F);
+
+    Mat labels, centers;
+
+    for (int m=0; m<nSubquantizers; m++){
+
+        Mat sub = projected.colRange(m * subDims, (m+1) * subDims).clone(); // kmeans needs continuous data
+
+        kmeans(sub, nCentroids, labels, TermCriteria(CV_TERMCRIT_ITER | CV_TERMCRIT_EPS, 25, 1e-4),
+               2, KMEANS_PP_CENTERS, centers);
+
+        centers.copyTo(codebooks.rowRange(m * nCentroids, (m+1) * nCentroids));
+    }
+
+    bTrained = true;
+
+    ofLogNotice("DescriptorCompressor") << "trained on " << descriptors.rows << " descriptors in "
+    << ofGetElapsedTimeMillis() - startTime << " ms, " << descriptors.cols * descriptors.elemSize()
+    << " -> " << getCodeBytes() << " bytes per descriptor";
+
+    return true;
+}
+
+bool DescriptorCompressor::isTrained() const{
+    return bTrained;
+}
+
+int DescriptorCompressor::getCodeBytes() const{
+    return nSubquantizers;
+}
+
+
+//--------------------------------------------------------------
+// PROJECT / ENCODE
+//--------------------------------------------------------------
+
+// same result as pca.project(), but subtracts the mean in place in the RootSIFT scratch rows
+// and projects with one gemm straight into projected, without PCA::project's temporaries
+// (no allocation when projected already has the right size)
+
+void DescriptorCompressor::project(const Mat& descriptors, Mat& projected){
+
+    if (pca.eigenvectors.empty()) return; // no PCA yet (train() sets it up before calling this, so not bTrained)
+
+    Mat& root = rootBuf.view(descriptors.rows, descriptors.cols, CV_32F);
+    rootSift(descriptors, root);
+
+    const float* mean = pca.mean.ptr<float>(0);
+
+    for (int i=0; i<root.rows; i++){
+        float* row = root.ptr<float>(i);
+        for (int j=0; j<root.cols; j++) row[j] -= mean[j];
+    }
+
+    gemm(root, pca.eigenvectors, 1, noArray(), 0, projected, GEMM_2_T);
+}
+
+void DescriptorCompressor::encode(const Mat& descriptors, Mat& codes){
+
+    if (!bTrained) return; // no codebooks to encode with
+
+    Mat& projected = projBuf.view(descriptors.rows, pcaDims, CV_32F);
+    project(descriptors, projected);
+
+    codes.create(descriptors.rows, nSubquantizers, CV_8U);
+
+    for (int i=0; i<projected.rows; i++){
+
+        const float* p = projected.ptr<float>(i);
+        uchar* code = codes.ptr<uchar>(i);
+
+        for (int m=0; m<nSubquantizers; m++){
+
+            const float* sub = p + m * subDims;
+            float bestDist = FLT_MAX;
+            int best = 0;
+
+            for (int c=0; c<nCentroids; c++){
+
+                const float* centroid = codebooks.ptr<float>(m * nCentroids + c);
+                float dist = 0;
+                for (int d=0; d<subDims; d++){
+                    float diff = sub[d] - centroid[d];
+                    dist += diff * diff;
+                }
+
+                if (dist < bestDist){
+                    bestDist = dist;
+                    best = c;
+                }
+            }
+
+            code[m] = best;
+        }
+    }
+}
+
+
+//--------------------------------------------------------------
+// ASYMMETRIC DISTANCE
+// table[m * 256 + c] = squared distance from the query's chunk m to centroid c
+// the distance to any code is then nSubquantizers table lookups + adds
+//--------------------------------------------------------------
+
+void DescriptorCompressor::computeDistanceTable(const float* projectedQuery, vector<float>& _table) const{
+
+    _table.resize(nSubquantizers * nCentroids);
+
+    for (int m=0; m<nSubquantizers; m++){
+
+        const float* sub = projectedQuery + m * subDims;
+
+        for (int c=0; c<nCentroids; c++){
+
+            const float* centroid = codebooks.ptr<float>(m * nCentroids + c);
+            float dist = 0;
+            for (int d=0; d<subDims; d++){
+                float diff = sub[d] - centroid[d];
+                dist += diff * diff;
+            }
+
+            _table[m * nCentroids + c] = dist;
+        }
+    }
+}
+
+float DescriptorCompressor::distance(const vector<float>& _table, const uchar* code) const{
+
+    const float* t = &_table[0];
+    float dist = 0;
+
+    for (int m=0; m<nSubquantizers; m++){
+        dist += t[m * nCentroids + code[m]];
+    }
+
+    return dist;
+}
+
+
+//--------------------------------------------------------------
+// MATCH
+//--------------------------------------------------------------
+
+void DescriptorCompressor::match(const Mat& queries, const Mat& codes, vector<DMatch>& matches, float ratio){
+
+    matches.clear();
+
+    if (!bTrained || queries.empty() || codes.rows < 2) return;
+
+    Mat& projected = queryBuf.view(queries.rows, pcaDims, CV_32F);
+    project(queries, projected);
+
+    const float ratioSq = ratio * ratio; // distances are squared
+
+    for (int i=0; i<projected.rows; i++){
+
+        computeDistanceTable(projected.ptr<float>(i), table);
+
+        float best = FLT_MAX, second = FLT_MAX;
+        int bestIdx = -1;
+
+        for (int j=0; j<codes.rows; j++){
+
+            float dist = distance(table, codes.ptr<uchar>(j));
+
+            if (dist < best){
+                second = best;
+                best = dist;
+                bestIdx = j;
+            } else if (dist < second){
+                second = dist;
+            }
+        }
+
+        if (bestIdx >= 0 && best < ratioSq * second){
+            matches.push_back(DMatch(i, bestIdx, sqrtf(best)));
+        }
+    }
+}
+
+
+//--------------------------------------------------------------
+// MEASURE RECALL
+// ground truth = exact nearest neighbor of each query among the database descriptors, twice:
+// L1 over the raw descriptors (SIFTMatcher's own matching, so everything compression changes counts)
+// and L2 over RootSIFT (the metric the codes approximate, so only PCA + PQ losses count).
+// measure on descriptors the compressor wasn't trained on, in-sample recall is optimistic
+//--------------------------------------------------------------
+
+DescriptorCompressor::Recall DescriptorCompressor::measureRecall(const Mat& queries, const Mat& database){
+
+    Recall recall;
+
+    if (!bTrained || queries.empty() || database.rows < 10) return recall;
+
+    BFMatcher exactRaw(NORM_L1);
+    vector<DMatch> truth;
+    exactRaw.match(queries, database, truth);
+
+    Mat rootQueries, rootDatabase;
+    rootSift(queries, rootQueries);
+    rootSift(database, rootDatabase);
+
+    BFMatcher exactRoot(NORM_L2);
+    vector<DMatch> rootTruth;
+    exactRoot.match(rootQueries, rootDatabase, rootTruth);
+
+    Mat codes, projected;
+    encode(database, codes);
+    project(queries, projected);
+
+    vector<pair<float,int>> ranked(codes.rows);
+    int hits1 = 0, hits10 = 0, rootHits1 = 0, rootHits10 = 0;
+
+    for (int i=0; i<projected.rows; i++){
+
+        computeDistanceTable(projected.ptr<float>(i), table);
+
+        for (int j=0; j<codes.rows; j++){
+            ranked[j] = make_pair(distance(table, codes.ptr<uchar>(j)), j);
+        }
+
+        partial_sort(ranked.begin(), ranked.begin() + 10, ranked.end());
+
+        hits1 += ranked[0].second == truth[i].trainIdx;
+        rootHits1 += ranked[0].second == rootTruth[i].trainIdx;
+
+        for (int r=0; r<10; r++){
+            hits10 += ranked[r].second == truth[i].trainIdx;
+            rootHits10 += ranked[r].second == rootTruth[i].trainIdx;
+        }
+    }
+
+    recall.at1 = (float) hits1 / queries.rows;
+    recall.at10 = (float) hits10 / queries.rows;
+    recall.rootAt1 = (float) rootHits1 / queries.rows;
+    recall.rootAt10 = (float) rootHits10 / queries.rows;
+
+    return recall;
+}
+
+
+//--------------------------------------------------------------
+// SAVE / LOAD
+//--------------------------------------------------------------
+
+bool DescriptorCompressor::save(string path) const{
+
+    if (!bTrained) return false;
+
+    FileStorage fs(ofToDataPath(path), FileStorage::WRITE);
+    if (!fs.isOpened()) return false;
+
+    fs << "pcaDims" << pcaDims << "nSubquantizers" << nSubquantizers;
+    fs << "pcaMean" << pca.mean << "pcaEigenvectors" << pca.eigenvectors;
+    fs << "codebooks" << codebooks;
+
+    return true;
+}
+
+bool DescriptorCompressor::load(string path){
+
+    FileStorage fs(ofToDataPath(path), FileStorage::READ);
+    if (!fs.isOpened()) return false;
+
+    int _pcaDims = 0, _nSubquantizers = 0;
+    fs["pcaDims"] >> _pcaDims;
+    fs["nSubquantizers"] >> _nSubquantizers;
+    setup(_pcaDims, _nSubquantizers);
+
+    fs["pcaMean"] >> pca.mean;
+    fs["pcaEigenvectors"] >> pca.eigenvectors;
+    fs["codebooks"] >> codebooks;
+
+    bTrained = !pca.eigenvectors.empty() && codebooks.rows == nSubquantizers * nCentroids;
+
+    return bTrained;
+}
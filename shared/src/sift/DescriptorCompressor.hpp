@@ -0,0 +1,82 @@
+//
+//  DescriptorCompressor.hpp
+//  SIFT_filterMatches_homography
+//
+
+#pragma once
+#include "ofMain.h"
+#include "ofxOpenCv.h"
+#include "ofxCv.h"
+
+#include "ReservedMat.hpp"
+
+using namespace cv;
+using namespace ofxCv;
+
+
+// compresses SIFT descriptors (128 floats = 512 bytes) to 16-32 byte codes:
+//   1. RootSIFT: L1 normalize + sqrt, so L2 distance behaves like the Hellinger kernel
+//   2. PCA down to pcaDims
+//   3. product quantization: split into nSubquantizers chunks, each replaced by
+//      the index of its nearest of 256 k-means centroids (1 byte per chunk)
+// matching is asymmetric (ADC): the query stays uncompressed, distances to all codes
+// come from one small lookup table per query (nSubquantizers x 256 floats)
+
+class DescriptorCompressor {
+
+public:
+
+    struct Recall {
+        // share of queries whose true nearest neighbor is in the top 1 / top 10 of the ADC search
+        float at1 = 0, at10 = 0; // true = L1 over the raw SIFT descriptors (what SIFTMatcher matches with)
+        float rootAt1 = 0, rootAt10 = 0; // true = L2 over RootSIFT (what the codes approximate: PCA + PQ loss only)
+    };
+
+    DescriptorCompressor();
+
+    void setup(int _pcaDims = 64, int _nSubquantizers = 16);
+    // code size in bytes = nSubquantizers, pcaDims must be divisible by it
+
+    static void rootSift(const Mat& src, Mat& dst);
+
+    bool train(const Mat& descriptors);
+    // learns PCA + codebooks from raw SIFT descriptors (needs at least 256 rows, more is better)
+
+    bool isTrained() const;
+    int getCodeBytes() const;
+
+    void project(const Mat& descriptors, Mat& projected);
+    // RootSIFT + PCA, CV_32F rows of pcaDims
+
+    void encode(const Mat& descriptors, Mat& codes);
+    // raw SIFT descriptors -> CV_8U rows of nSubquantizers
+    // project() and encode() don't allocate when their output already has the right size,
+    // and leave it untouched before training
+
+    void computeDistanceTable(const float* projectedQuery, vector<float>& table) const;
+    float distance(const vector<float>& table, const uchar* code) const; // squared L2 estimate
+
+    void match(const Mat& queries, const Mat& codes, vector<DMatch>& matches, float ratio = 0.8);
+    // nearest code per raw query descriptor, with Lowe's ratio test
+
+    Recall measureRecall(const Mat& queries, const Mat& database);
+    // compares ADC search over the encoded database against exact search over the raw descriptors,
+    // and against exact search over their RootSIFT vectors (use a database the compressor wasn't trained on)
+
+    bool save(string path) const;
+    bool load(string path);
+
+private:
+
+    int pcaDims = 64, nSubquantizers = 16, subDims = 4;
+    static const int nCentroids = 256;
+
+    PCA pca;
+    Mat codebooks; // nSubquantizers * nCentroids rows, subDims cols (CV_32F)
+    bool bTrained = false;
+
+    // scratch, grown to the largest descriptor count seen
+    ReservedMat rootBuf, projBuf, queryBuf;
+    vector<float> table;
+
+};
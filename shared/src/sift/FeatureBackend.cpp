@@ -0,0 +1,127 @@
+//
+//  FeatureBackend.cpp
+//  SIFT_filterMatches_homography
+//
+
+#include "FeatureBackend.hpp"
+
+
+bool FeatureBackend::isBinary() const{
+    return getNormType() == NORM_HAMMING || getNormType() == NORM_HAMMING2;
+}
+
+void FeatureBackend::detectAndCompute(const Mat& img, vector<KeyPoint>& keypoints, Mat& descriptors){
+    detect(img, keypoints);
+    compute(img, keypoints, descriptors);
+}
+
+
+//--------------------------------------------------------------
+// SIFT
+//--------------------------------------------------------------
+
+SiftBackend::SiftBackend(int _maxFeatures) : sift(_maxFeatures){
+    /*
+     // _maxFeatures = max number of keypoints to find
+     //  all optional constructor args, with default values:
+     //      (int nfeatures=0, int nOctaveLayers=3, double contrastThreshold=0.04,
+     //       double edgeThreshold=10, double sigma=1.6);
+     */
+}
+
+string SiftBackend::getName() const{
+    return "SIFT";
+}
+
+int SiftBackend::getNormType() const{
+    return NORM_L1;
+}
+
+void SiftBackend::detect(const Mat& img, vector<KeyPoint>& keypoints){
+    sift(img, noArray(), keypoints);
+}
+
+void SiftBackend::compute(const Mat& img, vector<KeyPoint>& keypoints, Mat& descriptors){
+    sift(img, noArray(), keypoints, descriptors, true); // true = describe the given keypoints
+}
+
+// SIFT::operator() with useProvidedKeypoints = false builds the Gaussian + DoG pyramids once,
+// finds extrema in the DoG, keeps the best nfeatures, then describes them from the same Gaussian pyramid.
+// detect() + compute() would build the whole pyramid twice (the dominant cost of SIFT)
+// and hold both copies' worth of allocations along the way
+
+void SiftBackend::detectAndCompute(const Mat& img, vector<KeyPoint>& keypoints, Mat& descriptors){
+    sift(img, noArray(), keypoints, descriptors, false);
+}
+
+
+//--------------------------------------------------------------
+// ORB
+// FAST corners + oriented BRIEF, 32 byte binary descriptor
+//--------------------------------------------------------------
+
+OrbBackend::OrbBackend(int _maxFeatures) : orb(_maxFeatures){
+}
+
+string OrbBackend::getName() const{
+    return "ORB";
+}
+
+int OrbBackend::getNormType() const{
+    return NORM_HAMMING;
+}
+
+void OrbBackend::detect(const Mat& img, vector<KeyPoint>& keypoints){
+    orb.detect(img, keypoints);
+}
+
+void OrbBackend::compute(const Mat& img, vector<KeyPoint>& keypoints, Mat& descriptors){
+    orb.compute(img, keypoints, descriptors);
+}
+
+void OrbBackend::detectAndCompute(const Mat& img, vector<KeyPoint>& keypoints, Mat& descriptors){
+    orb(img, noArray(), keypoints, descriptors, false); // one image pyramid for both
+}
+
+
+//--------------------------------------------------------------
+// BRISK
+// AGAST corners + sampling pattern pairs, 64 byte binary descriptor
+// has no keypoint cap of its own, so keep the strongest maxFeatures
+// (which is why it keeps the default detect-then-compute: the cap has to come before describing)
+//--------------------------------------------------------------
+
+BriskBackend::BriskBackend(int _maxFeatures) : maxFeatures(_maxFeatures){
+}
+
+string BriskBackend::getName() const{
+    return "BRISK";
+}
+
+int BriskBackend::getNormType() const{
+    return NORM_HAMMING;
+}
+
+void BriskBackend::detect(const Mat& img, vector<KeyPoint>& keypoints){
+    brisk.detect(img, keypoints);
+    KeyPointsFilter::retainBest(keypoints, maxFeatures);
+}
+
+void BriskBackend::compute(const Mat& img, vector<KeyPoint>& keypoints, Mat& descriptors){
+    brisk.compute(img, keypoints, descriptors);
+}
+
+
+//--------------------------------------------------------------
+// factory
+//--------------------------------------------------------------
+
+shared_ptr<FeatureBackend> createFeatureBackend(FeatureType type, int maxFeatures){
+
+    switch (type){
+        case FEATURE_ORB:   return shared_ptr<FeatureBackend>(new OrbBackend(maxFeatures));
+        case FEATURE_BRISK: return shared_ptr<FeatureBackend>(new BriskBackend(maxFeatures));
+        case FEATURE_SIFT:
+        default:            return shared_ptr<FeatureBackend>(new SiftBackend(maxFeatures));
+    }
+}
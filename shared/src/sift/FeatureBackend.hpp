@@ -0,0 +1,111 @@
+//
+//  FeatureBackend.hpp
+//  SIFT_filterMatches_homography
+//
+
+#pragma once
+#include "ofMain.h"
+#include "ofxOpenCv.h"
+#include "ofxCv.h"
+
+// include non-free OpenCV modules
+#include "opencv2/nonfree/nonfree.hpp"
+
+using namespace cv;
+using namespace ofxCv;
+
+
+// keypoint detector + descriptor pair used by SIFTMatcher
+// float descriptors (SIFT) are matched with L1 distance,
+// binary descriptors (ORB, BRISK) with Hamming distance
+
+enum FeatureType {
+    FEATURE_SIFT,   // 128 floats = 512 bytes per descriptor
+    FEATURE_ORB,    // 256 bits = 32 bytes
+    FEATURE_BRISK   // 512 bits = 64 bytes
+    // AKAZE would go here, but it's only in OpenCV 3+ (ofxOpenCv ships 2.4)
+};
+
+
+class FeatureBackend {
+
+public:
+
+    virtual ~FeatureBackend(){}
+
+    virtual string getName() const = 0;
+    virtual int getNormType() const = 0; // NORM_L1 for float descriptors, NORM_HAMMING for binary
+
+    virtual void detect(const Mat& img, vector<KeyPoint>& keypoints) = 0;
+    virtual void compute(const Mat& img, vector<KeyPoint>& keypoints, Mat& descriptors) = 0;
+
+    virtual void detectAndCompute(const Mat& img, vector<KeyPoint>& keypoints, Mat& descriptors);
+    // detect + compute in one pass, sharing the scale-space pyramid where the algorithm allows
+    // (default just calls detect then compute)
+
+    bool isBinary() const;
+
+};
+
+
+class SiftBackend : public FeatureBackend {
+
+public:
+
+    SiftBackend(int _maxFeatures = 2000);
+
+    string getName() const;
+    int getNormType() const;
+
+    void detect(const Mat& img, vector<KeyPoint>& keypoints);
+    void compute(const Mat& img, vector<KeyPoint>& keypoints, Mat& descriptors);
+    void detectAndCompute(const Mat& img, vector<KeyPoint>& keypoints, Mat& descriptors);
+
+private:
+
+    SIFT sift; // detector + extractor in one (SiftFeatureDetector / SiftDescriptorExtractor are typedefs of SIFT)
+
+};
+
+
+class OrbBackend : public FeatureBackend {
+
+public:
+
+    OrbBackend(int _maxFeatures = 2000);
+
+    string getName() const;
+    int getNormType() const;
+
+    void detect(const Mat& img, vector<KeyPoint>& keypoints);
+    void compute(const Mat& img, vector<KeyPoint>& keypoints, Mat& descriptors);
+    void detectAndCompute(const Mat& img, vector<KeyPoint>& keypoints, Mat& descriptors);
+
+private:
+
+    ORB orb;
+
+};
+
+
+class BriskBackend : public FeatureBackend {
+
+public:
+
+    BriskBackend(int _maxFeatures = 2000);
+
+    string getName() const;
+    int getNormType() const;
+
+    void detect(const Mat& img, vector<KeyPoint>& keypoints);
+    void compute(const Mat& img, vector<KeyPoint>& keypoints, Mat& descriptors);
+
+private:
+
+    BRISK brisk;
+    int maxFeatures;
+
+};
+
+
+shared_ptr<FeatureBackend> createFeatureBackend(FeatureType type, int maxFeatures = 2000);
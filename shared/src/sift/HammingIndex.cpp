@@ -0,0 +1,198 @@
+//
+//  HammingIndex.cpp
+//  SIFT_filterMatches_homography
+//
+
+#include "HammingIndex.hpp"
+
+
+HammingIndex::HammingIndex(){
+}
+
+void HammingIndex::setup(int _nTables, int _keyBits, bool _bMultiProbe){
+
+    nTables = max(1, _nTables);
+    keyBits = ofClamp(_keyBits, 1, 24);
+    bMultiProbe = _bMultiProbe;
+}
+
+
+//--------------------------------------------------------------
+// BUILD
+// one counting sort per table: count bucket sizes, prefix sum, scatter.
+// buckets are then contiguous runs in bucketIdx (no per-bucket vectors)
+//--------------------------------------------------------------
+
+void HammingIndex::build(const Mat& _descriptors){
+
+    descriptors = _descriptors;
+    nBytes = descriptors.cols;
+
+    const int n = descriptors.rows;
+    const int nBuckets = 1 << keyBits;
+
+    // random bits to sample, same every run
+
+    RNG rng(0xb175);
+    bitPositions.resize(nTables * keyBits);
+    for (int i=0; i<bitPositions.size(); i++){
+        bitPositions[i] = rng.uniform(0, nBytes * 8);
+    }
+
+    bucketStart.assign(nTables * (nBuckets + 1), 0);
+    bucketIdx.resize(nTables * n);
+
+    keys.resize(n);
+
+    for (int t=0; t<nTables; t++){
+
+        uint32_t* start = &bucketStart[t * (nBuckets + 1)];
+
+        for (int i=0; i<n; i++){
+            keys[i] = hashKey(descriptors.ptr<uchar>(i), t);
+            start[keys[i] + 1]++;
+        }
+
+        for (int b=0; b<nBuckets; b++){
+            start[b + 1] += start[b];
+        }
+
+        fillPos.assign(start, start + nBuckets); // write position per bucket
+        int* idx = n > 0 ? &bucketIdx[t * n] : NULL;
+
+        for (int i=0; i<n; i++){
+            idx[fillPos[keys[i]]++] = i;
+        }
+    }
+
+    visited.assign(n, 0);
+    stamp = 0;
+}
+
+
+uint32_t HammingIndex::hashKey(const uchar* desc, int table) const{
+
+    const int* bits = &bitPositions[table * keyBits];
+    uint32_t key = 0;
+
+    for (int j=0; j<keyBits; j++){
+        key |= (uint32_t) ((desc[bits[j] >> 3] >> (bits[j] & 7)) & 1) << j;
+    }
+
+    return key;
+}
+
+
+//--------------------------------------------------------------
+// KNN MATCH
+//--------------------------------------------------------------
+
+void HammingIndex::knnMatch(const uchar* query, int k, vector<DMatch>& result){
+
+    best.clear();
+
+    if (size() == 0) {
+        result.clear();
+        return;
+    }
+
+    if (++stamp == 0){ // wrapped around, clear the stamps
+        std::fill(visited.begin(), visited.end(), 0);
+        stamp = 1;
+    }
+
+    knnK = max(1, k);
+
+    for (int t=0; t<nTables; t++){
+
+        uint32_t key = hashKey(query, t);
+        collect(key, t, query);
+
+        if (bMultiProbe){
+            for (int b=0; b<keyBits; b++){
+                collect(key ^ (1u << b), t, query);
+            }
+        }
+    }
+
+    result = best;
+}
+
+
+// checks every not-yet-seen descriptor in one bucket, keeps best sorted
+
+void HammingIndex::collect(uint32_t key, int table, const uchar* query){
+
+    const int n = descriptors.rows;
+    const uint32_t* start = &bucketStart[table * ((1 << keyBits) + 1)];
+    const int* idx = &bucketIdx[table * n];
+
+    for (uint32_t i = start[key]; i < start[key + 1]; i++){
+
+        int row = idx[i];
+
+        if (visited[row] == stamp) continue;
+        visited[row] = stamp;
+
+        int dist = hammingDistance(query, descriptors.ptr<uchar>(row), nBytes);
+
+        // insertion into the short sorted list (k is 1 or 2 in practice)
+
+        if (best.size() < knnK || dist < best.back().distance){
+
+            DMatch m(0, row, (float) dist);
+            vector<DMatch>::iterator it = best.begin();
+            while (it != best.end() && it->distance <= dist) ++it;
+            best.insert(it, m);
+
+            if (best.size() > knnK) best.pop_back();
+        }
+    }
+}
+
+
+//--------------------------------------------------------------
+// MATCH
+// nearest neighbor per query + ratio test
+//--------------------------------------------------------------
+
+void HammingIndex::match(const Mat& queries, vector<DMatch>& matches, float ratio){
+
+    matches.clear();
+
+    // nothing to match on one side isn't an error: an ROI or frame without ORB / BRISK keypoints
+    // can come up every frame in tracking and ROI modes. only descriptors of another width are
+
+    if (queries.empty() || size() == 0 || nBytes == 0) return;
+
+    if (queries.cols != nBytes) {
+        ofLogError("HammingIndex") << "query descriptors are " << queries.cols << " bytes, index has " << nBytes;
+        return;
+    }
+
+    const float maxSingle = nBytes * 8 / 5.f; // only 1 candidate found: accept if < 20% bits differ
+
+    for (int i=0; i<queries.rows; i++){
+
+        knnMatch(queries.ptr<uchar>(i), 2, knn);
+
+        if (knn.empty()) continue;
+
+        bool bGood = (knn.size() == 1) ? knn[0].distance < maxSingle
+                                       : knn[0].distance < ratio * knn[1].distance;
+
+        if (bGood){
+            knn[0].queryIdx = i;
+            matches.push_back(knn[0]);
+        }
+    }
+}
+
+
+int HammingIndex::size() const{
+    return descriptors.rows;
+}
+
+size_t HammingIndex::getIndexBytes() const{
+    return bucketStart.size() * sizeof(uint32_t) + bucketIdx.size() * sizeof(int) + bitPositions.size() * sizeof(int);
+}
@@ -0,0 +1,106 @@
+//
+//  HammingIndex.hpp
+//  SIFT_filterMatches_homography
+//
+
+#pragma once
+#include "ofMain.h"
+#include "ofxOpenCv.h"
+#include "ofxCv.h"
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+using namespace cv;
+using namespace ofxCv;
+
+
+// # of differing bits between two binary descriptors
+// xor 8 bytes at a time + hardware popcount (POPCNT when built with -mpopcnt / -march=native)
+
+inline int hammingDistance(const uchar* a, const uchar* b, int nBytes){
+
+    int dist = 0;
+    int i = 0;
+
+    for (; i + 8 <= nBytes; i += 8){
+
+        uint64_t x, y;
+        memcpy(&x, a + i, 8); // memcpy = unaligned-safe load, compiles to a single mov
+        memcpy(&y, b + i, 8);
+
+#ifdef _MSC_VER
+        dist += (int) __popcnt64(x ^ y);
+#else
+        dist += __builtin_popcountll(x ^ y);
+#endif
+    }
+
+    for (; i < nBytes; i++){
+#ifdef _MSC_VER
+        dist += (int) __popcnt(a[i] ^ b[i]);
+#else
+        dist += __builtin_popcount(a[i] ^ b[i]);
+#endif
+    }
+
+    return dist;
+}
+
+
+// locality sensitive hashing index over binary descriptors (rows of a CV_8U Mat)
+// each table hashes a descriptor by a fixed random subset of its bits,
+// so near descriptors (few differing bits) likely share a bucket in at least one table.
+// candidates from all tables are then checked with the exact popcount distance
+
+class HammingIndex {
+
+public:
+
+    HammingIndex();
+
+    void setup(int _nTables = 6, int _keyBits = 14, bool _bMultiProbe = true);
+    // keyBits = bits sampled per table (buckets = 2^keyBits)
+    // multiProbe also checks buckets one bit away from the query's, fewer tables needed
+
+    void build(const Mat& _descriptors);
+    // shares _descriptors' data (a Mat header, no copy: the refcount keeps it alive),
+    // so build again after writing new descriptors into the same Mat
+
+    void knnMatch(const uchar* query, int k, vector<DMatch>& result);
+    // up to k nearest indexed descriptors, closest first (trainIdx = row in _descriptors)
+
+    void match(const Mat& queries, vector<DMatch>& matches, float ratio = 0.8);
+    // best match per query row that passes Lowe's ratio test against the 2nd best
+    // (queryIdx = row in queries)
+
+    int size() const;
+    size_t getIndexBytes() const; // memory used by the hash tables
+
+private:
+
+    uint32_t hashKey(const uchar* desc, int table) const;
+    void collect(uint32_t key, int table, const uchar* query);
+
+    int nTables = 6, keyBits = 14;
+    bool bMultiProbe = true;
+
+    Mat descriptors;
+    int nBytes = 0;
+
+    vector<int> bitPositions; // nTables * keyBits bit indices into a descriptor
+    vector<uint32_t> bucketStart; // per table, 2^keyBits + 1 offsets into bucketIdx (counting sort)
+    vector<int> bucketIdx; // per table, descriptor rows sorted by key
+
+    // build scratch, kept so rebuilding every frame doesn't allocate
+    vector<uint32_t> keys, fillPos;
+
+    // per query scratch
+    vector<uint32_t> visited; // stamp per descriptor, avoids checking one twice
+    uint32_t stamp = 0;
+    vector<DMatch> best; // sorted, at most knnK long
+    int knnK = 2;
+    vector<DMatch> knn; // match()'s 2 nearest per query
+
+};
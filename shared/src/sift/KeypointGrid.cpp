@@ -0,0 +1,89 @@
+//
+//  KeypointGrid.cpp
+//  SIFT_filterMatches_homography
+//
+
+#include "KeypointGrid.hpp"
+
+
+KeypointGrid::KeypointGrid(){
+}
+
+
+//--------------------------------------------------------------
+// BUILD
+// count keypoints per cell, prefix sum, scatter
+//--------------------------------------------------------------
+
+void KeypointGrid::build(const vector<KeyPoint>& keypoints, int width, int height, int _cellSize){
+
+    cellSize = max(1, _cellSize);
+    nCellsX = max(1, (width + cellSize - 1) / cellSize);
+    nCellsY = max(1, (height + cellSize - 1) / cellSize);
+
+    const int n = keypoints.size();
+
+    points.resize(n);
+    cellOf.resize(n);
+    cellStart.assign(nCellsX * nCellsY + 1, 0);
+    cellIdx.resize(n);
+
+    for (int i=0; i<n; i++){
+
+        points[i] = keypoints[i].pt;
+
+        int cx = ofClamp((int) (points[i].x / cellSize), 0, nCellsX - 1);
+        int cy = ofClamp((int) (points[i].y / cellSize), 0, nCellsY - 1);
+
+        cellOf[i] = cy * nCellsX + cx;
+        cellStart[cellOf[i] + 1]++;
+    }
+
+    for (int c=0; c<nCellsX * nCellsY; c++){
+        cellStart[c + 1] += cellStart[c];
+    }
+
+    fillPos.assign(cellStart.begin(), cellStart.end() - 1);
+
+    for (int i=0; i<n; i++){
+        cellIdx[fillPos[cellOf[i]]++] = i;
+    }
+}
+
+
+//--------------------------------------------------------------
+// QUERY
+//--------------------------------------------------------------
+
+void KeypointGrid::query(const Point2f& center, float radius, vector<int>& result) const{
+
+    result.clear();
+
+    if (points.empty()) return;
+
+    int x0 = ofClamp((int) floor((center.x - radius) / cellSize), 0, nCellsX - 1);
+    int x1 = ofClamp((int) floor((center.x + radius) / cellSize), 0, nCellsX - 1);
+    int y0 = ofClamp((int) floor((center.y - radius) / cellSize), 0, nCellsY - 1);
+    int y1 = ofClamp((int) floor((center.y + radius) / cellSize), 0, nCellsY - 1);
+
+    const float radiusSq = radius * radius;
+
+    for (int cy = y0; cy <= y1; cy++){
+        for (int cx = x0; cx <= x1; cx++){
+
+            int c = cy * nCellsX + cx;
+
+            for (int k = cellStart[c]; k < cellStart[c + 1]; k++){
+
+                int i = cellIdx[k];
+                Point2f d = points[i] - center;
+
+                if (d.dot(d) <= radiusSq) result.push_back(i);
+            }
+        }
+    }
+}
+
+int KeypointGrid::size() const{
+    return points.size();
+}
@@ -0,0 +1,42 @@
+//
+//  KeypointGrid.hpp
+//  SIFT_filterMatches_homography
+//
+
+#pragma once
+#include "ofMain.h"
+#include "ofxOpenCv.h"
+#include "ofxCv.h"
+
+using namespace cv;
+using namespace ofxCv;
+
+
+// uniform grid over an image's keypoints, for "which keypoints are near this point" lookups.
+// built with a counting sort like HammingIndex's buckets: each cell's keypoint indices
+// are one contiguous run of cellIdx, so lookups only touch the few cells around the point
+
+class KeypointGrid {
+
+public:
+
+    KeypointGrid();
+
+    void build(const vector<KeyPoint>& keypoints, int width, int height, int _cellSize = 32);
+    // width, height = image size (keypoints outside it go to the border cells)
+
+    void query(const Point2f& center, float radius, vector<int>& result) const;
+    // indices of keypoints within radius of center (result is cleared first)
+
+    int size() const;
+
+private:
+
+    int cellSize = 32, nCellsX = 0, nCellsY = 0;
+
+    vector<Point2f> points; // keypoint locations, in build order
+    vector<int> cellStart; // nCellsX * nCellsY + 1 offsets into cellIdx
+    vector<int> cellIdx; // keypoint indices sorted by cell
+    vector<int> cellOf, fillPos; // build scratch
+
+};
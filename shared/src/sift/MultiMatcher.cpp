@@ -0,0 +1,340 @@
+//
+//  MultiMatcher.cpp
+//  SIFT_filterMatches_homography
+//
+
+#include "MultiMatcher.hpp"
+
+
+//--------------------------------------------------------------
+// per-query homography body
+// each query's matches are independent, so the TaskScheduler
+// can fit their homographies on all cores at once
+//--------------------------------------------------------------
+
+namespace {
+
+    class FitHomographies : public ParallelLoopBody {
+
+    public:
+
+        FitHomographies(const vector<vector<Point2f>>& _src, const vector<vector<Point2f>>& _dst,
+                        vector<Mat>& _homographies, vector<vector<uchar>>& _masks, int _minInliers)
+        : src(_src), dst(_dst), homographies(_homographies), masks(_masks), minInliers(_minInliers) {}
+
+        void operator()(const Range& range) const {
+
+            for (int q = range.start; q < range.end; q++){
+
+                homographies[q].release();
+
+                if (src[q].size() < minInliers) continue; // too little support to be found anyway
+
+                homographies[q] = findHomography(src[q], dst[q], RANSAC, 3, masks[q]);
+            }
+        }
+
+    private:
+
+        const vector<vector<Point2f>>& src;
+        const vector<vector<Point2f>>& dst;
+        vector<Mat>& homographies;
+        vector<vector<uchar>>& masks;
+        int minInliers;
+
+    };
+
+
+    // a real view of a flat query is a convex quad that keeps its corner order (no mirroring)
+    // and isn't collapsed to a sliver
+
+    bool isPlausibleQuad(const vector<Point2f>& quad){
+
+        float sign = 0;
+        float area = 0;
+
+        for (int i=0; i<4; i++){
+
+            const Point2f& a = quad[i];
+            const Point2f& b = quad[(i+1) % 4];
+            const Point2f& c = quad[(i+2) % 4];
+
+            float cross = (b.x - a.x) * (c.y - b.y) - (b.y - a.y) * (c.x - b.x);
+
+            if (cross == 0 || (sign != 0 && (cross > 0) != (sign > 0))) return false; // concave / degenerate
+            sign = cross;
+
+            area += a.x * b.y - b.x * a.y;
+        }
+
+        return sign > 0 && fabs(area) * 0.5 > 100; // clockwise in image coordinates (y down), like the query's corners
+    }
+
+}
+
+
+MultiMatcher::MultiMatcher(){
+}
+
+void MultiMatcher::setup(FeatureType type, int maxFeatures, int _minInliers, float _ratio){
+
+    backend = createFeatureBackend(type, maxFeatures);
+    minInliers = max(4, _minInliers); // homography needs at least 4
+    ratio = _ratio;
+
+    clearQueries();
+}
+
+
+//--------------------------------------------------------------
+// QUERIES
+//--------------------------------------------------------------
+
+int MultiMatcher::addQuery(ofImage& queryImg, string name){
+
+    return addQuery(toCv(queryImg.getPixels()), name);
+}
+
+int MultiMatcher::addQuery(const Mat& querySrc, string name){
+
+    if (!backend) setup();
+
+    GrayscaleCache gray;
+    const Mat& queryMat = gray.get(querySrc);
+
+    vector<KeyPoint> keypoints;
+    Mat descriptors;
+
+    backend->detectAndCompute(queryMat, keypoints, descriptors);
+
+    int queryId = queryNames.size();
+
+    queryNames.push_back(name.empty() ? "query " + ofToString(queryId) : name);
+    querySizes.push_back(ofVec2f(queryMat.cols, queryMat.rows));
+    queryKeypoints.push_back(keypoints);
+
+    if (queryStart.empty()) queryStart.push_back(0);
+    queryStart.push_back(queryStart.back() + descriptors.rows);
+    rowQuery.insert(rowQuery.end(), descriptors.rows, queryId);
+
+    queryDescriptors.push_back(descriptors); // appends rows
+
+    bIndexDirty = true;
+
+    ofLogNotice("MultiMatcher") << "added " << queryNames.back() << ": " << keypoints.size() << " keypoints";
+
+    return queryId;
+}
+
+void MultiMatcher::clearQueries(){
+
+    queryNames.clear();
+    querySizes.clear();
+    queryKeypoints.clear();
+    queryStart.clear();
+    rowQuery.clear();
+    queryDescriptors.release();
+    floatIndex.release();
+    detections.clear();
+    bIndexDirty = true;
+}
+
+int MultiMatcher::getNumQueries() const{
+    return queryNames.size();
+}
+
+string MultiMatcher::getQueryName(int queryId) const{
+    return queryNames[queryId];
+}
+
+
+//--------------------------------------------------------------
+// INDEX
+//--------------------------------------------------------------
+
+void MultiMatcher::buildIndex(){
+
+    uint64_t startTime = ofGetElapsedTimeMillis();
+
+    if (backend->isBinary()){
+        hammingIndex.build(queryDescriptors);
+    } else {
+        // 4 randomized kd-trees, searched together (approximate, but ~log(n) per lookup)
+        floatIndex = new cv::flann::Index(queryDescriptors, cv::flann::KDTreeIndexParams(4));
+    }
+
+    bIndexDirty = false;
+
+    ofLogNotice("MultiMatcher") << "indexed " << queryDescriptors.rows << " descriptors of "
+    << getNumQueries() << " queries in " << ofGetElapsedTimeMillis() - startTime << " ms";
+}
+
+
+// nearest query descriptor per field descriptor, with ratio test
+
+void MultiMatcher::matchToQueries(){
+
+    matches.clear();
+
+    if (fieldDescriptors.empty()) return; // detect() made sure there are query descriptors
+
+    if (backend->isBinary()){
+        hammingIndex.match(fieldDescriptors, matches, ratio);
+        return;
+    }
+
+    floatIndex->knnSearch(fieldDescriptors, knnIndices, knnDists, 2, cv::flann::SearchParams(32));
+
+    const float ratioSq = ratio * ratio; // FLANN distances are squared L2
+
+    for (int i=0; i<fieldDescriptors.rows; i++){
+
+        const int* idx = knnIndices.ptr<int>(i);
+        const float* dist = knnDists.ptr<float>(i);
+
+        if (idx[0] >= 0 && dist[0] < ratioSq * dist[1]){
+            matches.push_back(DMatch(i, idx[0], sqrtf(dist[0])));
+        }
+    }
+}
+
+
+//--------------------------------------------------------------
+// DETECT
+//--------------------------------------------------------------
+
+const vector<MultiMatcher::Detection>& MultiMatcher::detect(ofImage& fieldImg){
+
+    return detect(toCv(fieldImg.getPixels()));
+}
+
+const vector<MultiMatcher::Detection>& MultiMatcher::detect(const Mat& fieldSrc){
+
+    detections.clear();
+
+    // no queries, or none with enough descriptors to match against (flat logos, tiny crops):
+    // checked before building, an index over an empty Mat asserts in OpenCV
+
+    if (getNumQueries() == 0 || queryDescriptors.rows < 2) return detections;
+
+    if (bIndexDirty) buildIndex();
+
+    uint64_t startTime = ofGetElapsedTimeMillis();
+
+
+    // 1. describe fieldImg, once for all queries
+
+    const Mat& fieldMat = fieldGray.get(fieldSrc, ++fieldGeneration);
+    backend->detectAndCompute(fieldMat, fieldKeypoints, fieldDescriptors);
+
+    uint64_t describeTime = ofGetElapsedTimeMillis() - startTime;
+    startTime = ofGetElapsedTimeMillis();
+
+
+    // 2. one lookup per field descriptor in the shared index
+
+    matchToQueries();
+
+    uint64_t matchTime = ofGetElapsedTimeMillis() - startTime;
+    startTime = ofGetElapsedTimeMillis();
+
+
+    // 3. group the matches by query
+
+    const int nQueries = getNumQueries();
+
+    srcPts.resize(nQueries);
+    dstPts.resize(nQueries);
+    homographies.resize(nQueries);
+    inlierMasks.resize(nQueries);
+
+    for (int q=0; q<nQueries; q++){
+        srcPts[q].clear();
+        dstPts[q].clear();
+    }
+
+    for (int i=0; i<matches.size(); i++){
+
+        int row = matches[i].trainIdx;
+        int q = rowQuery[row];
+
+        srcPts[q].push_back(queryKeypoints[q][row - queryStart[q]].pt);
+        dstPts[q].push_back(fieldKeypoints[matches[i].queryIdx].pt);
+    }
+
+
+    // 4. homography per query with enough matches, in parallel
+
+    FitHomographies fit(srcPts, dstPts, homographies, inlierMasks, minInliers);
+    TaskScheduler::get().parallelFor(0, nQueries, 1, [&](int begin, int end){ fit(Range(begin, end)); });
+
+    vector<Point2f> queryCorners(4), fieldCorners(4);
+
+    for (int q=0; q<nQueries; q++){
+
+        if (homographies[q].empty()) continue;
+
+        int nInliers = countNonZero(inlierMasks[q]);
+        if (nInliers < minInliers) continue;
+
+        queryCorners[0] = Point2f(0, 0);
+        queryCorners[1] = Point2f(querySizes[q].x, 0);
+        queryCorners[2] = Point2f(querySizes[q].x, querySizes[q].y);
+        queryCorners[3] = Point2f(0, querySizes[q].y);
+
+        perspectiveTransform(queryCorners, fieldCorners, homographies[q]);
+
+        if (!isPlausibleQuad(fieldCorners)) continue;
+
+        Detection d;
+        d.queryId = q;
+        d.homography = homographies[q].clone();
+        d.nMatches = srcPts[q].size();
+        d.nInliers = nInliers;
+        for (int c=0; c<4; c++) d.corners.push_back(toOf(fieldCorners[c]));
+
+        detections.push_back(d);
+    }
+
+    uint64_t homographyTime = ofGetElapsedTimeMillis() - startTime;
+
+    ofLogNotice("MultiMatcher") << "found " << detections.size() << " of " << nQueries << " queries: "
+    << fieldKeypoints.size() << " field keypoints described in " << describeTime << " ms, "
+    << matches.size() << " matches in " << matchTime << " ms, homographies in " << homographyTime << " ms";
+
+    return detections;
+}
+
+const vector<MultiMatcher::Detection>& MultiMatcher::getDetections() const{
+    return detections;
+}
+
+
+//--------------------------------------------------------------
+// DRAW
+//--------------------------------------------------------------
+
+void MultiMatcher::draw(float x, float y, ofColor color, float lineWidth){
+
+    ofPushStyle();
+    ofPushMatrix();
+    ofTranslate(x, y);
+
+        ofSetColor(color);
+        ofSetLineWidth(lineWidth);
+
+        for (int i=0; i<detections.size(); i++){
+
+            const vector<ofVec2f>& c = detections[i].corners;
+
+            for (int j=0; j<4; j++){
+                ofDrawLine(c[j], c[(j+1) % 4]);
+            }
+
+            ofDrawBitmapStringHighlight(queryNames[detections[i].queryId] + " (" + ofToString(detections[i].nInliers) + ")",
+                                        c[0].x, c[0].y - 4, ofColor(0, 150), color);
+        }
+
+    ofPopMatrix();
+    ofPopStyle();
+}
@@ -0,0 +1,104 @@
+//
+//  MultiMatcher.hpp
+//  SIFT_filterMatches_homography
+//
+
+#pragma once
+#include "ofMain.h"
+#include "ofxOpenCv.h"
+#include "ofxCv.h"
+
+#include "FeatureBackend.hpp"
+#include "HammingIndex.hpp"
+#include "GrayscaleCache.hpp"
+#include "TaskScheduler.hpp"
+
+using namespace cv;
+using namespace ofxCv;
+
+
+// finds many query images (logos, props...) in one fieldImg in a single pass:
+//   - each query is described once, when added, and all query descriptors go into one shared index
+//     (FLANN kd-tree forest for float descriptors, LSH HammingIndex for binary ones)
+//   - per field frame: fieldImg is described once, each field descriptor looks up its 2 nearest
+//     query descriptors in the index (ratio test), so cost grows with log(# query descriptors), not # queries
+//   - matches are grouped by query, and every query with enough of them gets its own homography
+//     (in parallel), kept if enough matches agree with it and the quad it makes is plausible
+
+class MultiMatcher {
+
+public:
+
+    struct Detection {
+        int queryId;
+        Mat homography; // query -> fieldImg
+        vector<ofVec2f> corners; // query's corners in fieldImg
+        int nMatches, nInliers;
+    };
+
+    MultiMatcher();
+
+    void setup(FeatureType type = FEATURE_SIFT, int maxFeatures = 2000, int _minInliers = 10, float _ratio = 0.8);
+    // minInliers = matches that have to agree with a query's homography to count as found
+    // ratio = Lowe's ratio test between a field descriptor's 2 nearest query descriptors
+
+    int addQuery(ofImage& queryImg, string name = "");
+    int addQuery(const Mat& queryMat, string name = "");
+    // describes the query + adds it to the index (rebuilt on the next detect()), returns its id
+    void clearQueries();
+
+    int getNumQueries() const;
+    string getQueryName(int queryId) const;
+
+    const vector<Detection>& detect(ofImage& fieldImg);
+    const vector<Detection>& detect(const Mat& fieldMat);
+    // all queries found in fieldImg, fieldImg isn't changed
+    // (Mats: grayscale, RGB or RGBA in oF channel order)
+    const vector<Detection>& getDetections() const;
+
+    void draw(float x = 0, float y = 0, ofColor color = ofColor::magenta, float lineWidth = 2);
+    // quads + names of the last detections, in fieldImg coordinates
+
+    vector<KeyPoint> fieldKeypoints; // from the last detect()
+    Mat fieldDescriptors;
+
+private:
+
+    void buildIndex();
+    void matchToQueries();
+
+    shared_ptr<FeatureBackend> backend;
+    int minInliers = 10;
+    float ratio = 0.8;
+
+
+    // queries
+    // every query's descriptors are rows of queryDescriptors, query q owns rows queryStart[q] to queryStart[q+1]
+
+    vector<string> queryNames;
+    vector<ofVec2f> querySizes;
+    vector<vector<KeyPoint>> queryKeypoints;
+    vector<int> queryStart;
+    vector<int> rowQuery; // query id of each row of queryDescriptors
+    Mat queryDescriptors;
+
+
+    // shared index over queryDescriptors (which it points into, so don't change those without rebuilding)
+
+    bool bIndexDirty = true;
+    Ptr<cv::flann::Index> floatIndex;
+    HammingIndex hammingIndex;
+
+
+    // per frame, reused
+
+    GrayscaleCache fieldGray;
+    uint64_t fieldGeneration = 0;
+    Mat knnIndices, knnDists;
+    vector<DMatch> matches; // queryIdx = field keypoint, trainIdx = row of queryDescriptors
+    vector<vector<Point2f>> srcPts, dstPts; // per query: matched query points, matched field points
+    vector<Mat> homographies;
+    vector<vector<uchar>> inlierMasks;
+    vector<Detection> detections;
+
+};
@@ -0,0 +1,49 @@
+//
+//  ReservedMat.hpp
+//  SIFT_filterMatches_homography
+//
+
+#pragma once
+#include "ofMain.h"
+#include "ofxOpenCv.h"
+#include "ofxCv.h"
+
+using namespace cv;
+using namespace ofxCv;
+
+
+// a Mat with spare rows, for per-frame buffers whose row count changes every frame
+// (one row per keypoint / descriptor). Mat::create() reallocates on any size change,
+// view() instead returns the first rows of a buffer that only reallocates when it has to grow
+
+class ReservedMat {
+
+public:
+
+    Mat& view(int rows, int cols, int type){
+
+        if (storage.rows < rows || storage.cols != cols || storage.type() != type){
+            storage.create(max(rows, storage.rows + storage.rows / 2), cols, type); // grow 1.5x
+            nReallocations++;
+        }
+
+        rowsView = storage.rowRange(0, rows); // header only, no copy
+        return rowsView;
+    }
+    // writing into the view with functions that call create() on their output
+    // (convertTo, gemm, copyTo...) is fine, it already has the size and type they ask for
+
+    void reserve(int rows, int cols, int type){
+        view(rows, cols, type);
+    }
+
+    int getReallocations() const{
+        return nReallocations;
+    }
+
+private:
+
+    Mat storage, rowsView;
+    int nReallocations = 0;
+
+};
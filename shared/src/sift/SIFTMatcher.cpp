@@ -0,0 +1,1068 @@
+//
+//  SIFTMatcher.cpp
+//  SIFT_filterMatches_homography
+//
+//  Created by Tyler on 3/24/16.
+//
+//
+
+#include "SIFTMatcher.hpp"
+
+
+//--------------------------------------------------------------
+// Constructor
+//--------------------------------------------------------------
+
+// default constructor - blank
+SIFTMatcher::SIFTMatcher(){
+}
+
+
+// matcher for two ofImages, used by match() and the draw functions
+// (leave it out to only use match(findMat, fieldMat))
+SIFTMatcher::SIFTMatcher(ofImage& _findImg, ofImage& _fieldImg){
+    
+    findImg = &_findImg;
+    fieldImg = &_fieldImg;
+    
+}
+
+//-------------------------------------------------------------------------
+// MATCH
+// runs SIFT keypoint detection and feature descriptor on findImg, fieldImg
+// then matches their descriptors (see matchDescriptors())
+//-------------------------------------------------------------------------
+
+void SIFTMatcher::match(){
+    
+    // takes in a query image (findImg) and "train" image (fieldImg)
+    // returns the matches vector (unfiltered)
+    
+    // also references findImg, fieldImg as public findImg, fieldImg
+    // and saves resulting KeyPoints vectors as public variables
+    
+    match(toCv(findImg->getPixels()), toCv(fieldImg->getPixels())); // wraps the pixels, no copy
+}
+
+
+void SIFTMatcher::match(const Mat& findSrc, const Mat& fieldSrc){
+    
+    
+    uint64_t startTime = ofGetElapsedTimeMillis(); // save start time (in ms) for testing speed
+    
+    
+    //---------------------//
+    //---- LOAD IMAGES ----//
+    //---------------------//
+
+    
+    
+    // grayscale Mats of the images (SIFT works in grayscale)
+    // converted into the matcher's own buffers, findImg and fieldImg stay as they are.
+    // every match() is taken to be a new fieldImg frame (except the ROI fallback's retry of the same one),
+    // findImg is only converted again after findImgChanged() or if its pixels were reallocated
+    
+    if (!bRoiRetry) fieldGeneration++;
+    
+    const Mat& findMat = findGray.get(findSrc, findGeneration);
+    const Mat& fieldMat = fieldGray.get(fieldSrc, fieldGeneration);
+    
+    
+    // in ROI mode, only search fieldImg around where findImg was last found
+    
+    bool bSearchRoi = updateSearchRect(fieldMat);
+    bMatchedRoi = bSearchRoi; // the full-image retries below set it back to false
+    Mat fieldSearchMat = fieldMat(searchRect); // no copy, just a view into fieldMat
+    
+    
+    // print image load time
+    // --------------
+    uint64_t loadTime = ofGetElapsedTimeMillis() - startTime; // calc image load time
+    if (bLogging) ofLogNotice("siftMatch") << "took " << loadTime << " ms to prep images" << endl; // print load time to console
+    startTime = ofGetElapsedTimeMillis();   // reset startTime
+    // --------------
+    
+    
+    
+    //------------------------------------//
+    //---- SIFT DETECTION/DESCRIPTION ----//
+    //------------------------------------//
+    
+    
+    // -------------------------------------------------------
+    // 1. DETECT + DESCRIBE SIFT keypoints/features in both images
+    // -------------------------------------------------------
+    
+    
+    if (!backend){
+        setFeatureBackend(FEATURE_SIFT, 2000); // SIFT by default, 2000 = max number of keypoints to find
+    }
+    
+    
+    // one pass per image: the backend builds its scale-space pyramid once
+    // and describes the keypoints it found from that same pyramid
+    // (separate detect() + compute() calls would each build their own)
+    
+    // findDescriptors, fieldDescriptors: matrices to hold all features per keypoint in image
+    // i.e. in each matrix, row 'i' is the list of features for keypoint 'i'
+    
+    backend->detectAndCompute(findMat, findKeypoints, findDescriptors);
+    backend->detectAndCompute(fieldSearchMat, fieldKeypoints, fieldDescriptors);
+    
+    // move ROI keypoints back to fieldImg coords
+    
+    if (bSearchRoi){
+        Point2f offset(searchRect.x, searchRect.y);
+        for (int i=0; i<fieldKeypoints.size(); i++){
+            fieldKeypoints[i].pt += offset;
+        }
+    }
+    
+    
+    // print results
+    // --------------
+    uint64_t describeTime = ofGetElapsedTimeMillis() - startTime; // calculate detection + description time
+    
+    // print # keypoints found and some statistics on the matrices
+    
+    cv::Size findSize = findDescriptors.size(); // size of matrix
+    cv::Size fieldSize = fieldDescriptors.size();
+    
+    descriptorBytes = findDescriptors.cols * findDescriptors.elemSize(); // memory per keypoint
+    
+    if (bLogging) ofLogNotice("SIFTMatcher") << "took " << describeTime << " ms to find + describe " << backend->getName() << " keypoints" << endl << endl
+    << "          # keypoints found" << endl
+    << "          -----------------" << endl
+    << "            findImg: " << findKeypoints.size() << endl
+    << "            fieldImg: " << fieldKeypoints.size() << endl
+    << "          searched " << (bSearchRoi ? "ROI " : "full ") << searchRect.width << "x" << searchRect.height << " of fieldImg" << endl
+    << endl
+    << "          findImg feature matrix" << endl
+    << "          ----------------------" << endl
+    << "            height: " << findSize.height << ", width: " << findSize.width << endl
+    << "            area: " << findSize.area() << ", non-zero: " << countNonZero(findDescriptors) << endl
+    << endl
+    << "          fieldImg feature matrix" << endl
+    << "          -----------------------" << endl
+    << "            height: " << fieldSize.height << ", width: " << fieldSize.width << endl
+    << "            area: " << fieldSize.area() << ", non-zero: " << countNonZero(fieldDescriptors) << endl;
+    
+    startTime = ofGetElapsedTimeMillis();   // reset startTime
+    // --------------
+    
+    
+    
+    //---------------------------------//
+    //---- FIND MATCHING KEYPOINTS ----//
+    //---------------------------------//
+    
+    
+    matchDescriptors();
+    
+    
+    // print results
+    // --------------
+    uint64_t matchTime = ofGetElapsedTimeMillis() - startTime; // calculate match time
+    
+    if (bLogging){
+        ofLogNotice("SIFTMatcher") << "took " << matchTime << " ms to match keypoints" << endl << endl
+        << "          Found " <<  matches.size() << " matching keypoints" << endl;
+    }
+    // --------------
+    
+    
+    // ROI fallback: findImg probably moved out of the ROI, search the full fieldImg
+    
+    if (bSearchRoi && matches.size() < minRoiMatches){
+        
+        if (bLogging) ofLogNotice("SIFTMatcher") << "only " << matches.size() << " matches in ROI, falling back to full fieldImg";
+        
+        bRoiValid = false;
+        bRoiRetry = true;
+        match(findSrc, fieldSrc);
+        bRoiRetry = false;
+    }
+
+    
+}
+
+
+//--------------------------------------------------------------
+// RETRY FULL IMAGE
+// the ROI search had matches but no homography came out of them: findImg may have
+// moved off the ROI, so match this same frame again over all of fieldImg and re-fit
+// (like match()'s fallback when the ROI has too few matches)
+//--------------------------------------------------------------
+
+bool SIFTMatcher::retryFullImage(bool bUseGoodMatches){
+    
+    if (bLogging) ofLogNotice("SIFTMatcher") << "no homography from the ROI search, retrying with the full fieldImg";
+    
+    // the grayscale Mats of this frame, as sources again (headers hold the pixels while match() re-wraps them)
+    Mat findMat = findGray.get();
+    Mat fieldMat = fieldGray.get();
+    
+    bRoiValid = false;
+    bRoiRetry = true;
+    match(findMat, fieldMat); // not an ROI search now, so no second retry
+    bRoiRetry = false;
+    
+    if (bUseGoodMatches) filterMatches();
+    
+    return getHomography(bUseGoodMatches); // not from an ROI now, so a failure clears the homography
+}
+
+
+//--------------------------------------------------------------
+// MATCH DESCRIPTORS
+// matches findDescriptors against fieldDescriptors into matches,
+// all through buffers kept between calls (no allocation once warmed up)
+//--------------------------------------------------------------
+
+void SIFTMatcher::matchDescriptors(){
+    
+    bMeshDirty = true; // new matches, drawMatchesMesh() rebuilds
+    goodMatchThreshold = 0; // filterMatches hasn't seen these yet
+    
+    if (backend && backend->isBinary()){
+        
+        // binary descriptors: hash fieldImg's descriptors into an LSH index,
+        // then look up each findImg descriptor (popcount Hamming distance + ratio test)
+        
+        hammingIndex.build(fieldDescriptors);
+        hammingIndex.match(findDescriptors, matches);
+        
+    } else if (compressor){
+        
+        // compressed: fieldImg descriptors stored as PQ codes,
+        // findImg descriptors compared to them with asymmetric distance lookup tables
+        
+        if (!compressor->isTrained()){
+            compressor->train(fieldDescriptors); // fails on fields with fewer than 256 descriptors
+        }
+        
+        if (compressor->isTrained()){
+            fieldCodes = codesBuf.view(fieldDescriptors.rows, compressor->getCodeBytes(), CV_8U);
+            compressor->encode(fieldDescriptors, fieldCodes);
+            compressor->match(findDescriptors, fieldCodes, matches);
+        } else {
+            crossCheckMatch(backend ? backend->getNormType() : NORM_L1); // uncompressed until a field trains it
+        }
+        
+    } else {
+        
+        crossCheckMatch(backend ? backend->getNormType() : NORM_L1);
+    }
+}
+
+
+// brute force matching with cross check, same result as BFMatcher(normType, true):
+// loops through every feature in findDescriptors, comparing it to every feature in fieldDescriptors,
+// and only keeps a match when both keypoints find each other as their closest match.
+// (a good visual example of cross-checking is on StackOverflow: http://stackoverflow.com/questions/11181823/why-we-need-crosscheckmatching-for-feature)
+//
+// BFMatcher does that as two knn searches (find -> field, then field -> find) with per-call result vectors.
+// here one pass over all pairs keeps the best per row and per column at once, in member buffers.
+// the rows are split into chunks run as TaskScheduler tasks: each chunk owns its rows' bests,
+// and keeps its own per column bests that are merged afterwards (in chunk order, so ties go to
+// the lowest row like in a single pass, the result doesn't depend on the # of threads)
+
+void SIFTMatcher::crossCheckMatch(int normType){
+    
+    matches.clear();
+    
+    const int nFind = findDescriptors.rows, nField = fieldDescriptors.rows;
+    if (nFind == 0 || nField == 0) return;
+    
+    if (findDescriptors.type() != CV_32F || fieldDescriptors.type() != CV_32F || findDescriptors.cols != fieldDescriptors.cols){
+        ofLogError("SIFTMatcher") << "crossCheckMatch needs float descriptors of the same length";
+        return;
+    }
+    
+    const bool bL2 = (normType == NORM_L2 || normType == NORM_L2SQR);
+    
+    TaskScheduler& scheduler = TaskScheduler::get();
+    const int nChunks = min(scheduler.getNumThreads() * 2, max(nFind / 32, 1)); // at least 32 rows per chunk
+    
+    bestField.assign(nFind, -1);
+    bestFieldDist.assign(nFind, FLT_MAX);
+    chunkBestFind.assign(nChunks * nField, -1);
+    chunkBestFindDist.assign(nChunks * nField, FLT_MAX);
+    
+    // small capture, so the std::function holding it doesn't allocate
+    scheduler.parallelFor(0, nChunks, 1, [this, nChunks, bL2](int chunkBegin, int chunkEnd){
+        for (int c=chunkBegin; c<chunkEnd; c++){
+            crossCheckChunk(c, nChunks, bL2);
+        }
+    });
+    
+    // merge the chunks' column bests
+    
+    bestFind.assign(chunkBestFind.begin(), chunkBestFind.begin() + nField);
+    bestFindDist.assign(chunkBestFindDist.begin(), chunkBestFindDist.begin() + nField);
+    
+    for (int c=1; c<nChunks; c++){
+        for (int j=0; j<nField; j++){
+            if (chunkBestFindDist[c * nField + j] < bestFindDist[j]){
+                bestFindDist[j] = chunkBestFindDist[c * nField + j];
+                bestFind[j] = chunkBestFind[c * nField + j];
+            }
+        }
+    }
+    
+    for (int i=0; i<nFind; i++){
+        
+        int j = bestField[i];
+        
+        if (j >= 0 && bestFind[j] == i){
+            matches.push_back(DMatch(i, j, bL2 ? sqrtf(bestFieldDist[i]) : bestFieldDist[i]));
+        }
+    }
+}
+
+
+void SIFTMatcher::crossCheckChunk(int chunk, int nChunks, bool bL2){
+    
+    const int nFind = findDescriptors.rows, nField = fieldDescriptors.rows;
+    const int dims = findDescriptors.cols;
+    
+    int* colBest = &chunkBestFind[chunk * nField];
+    float* colBestDist = &chunkBestFindDist[chunk * nField];
+    
+    for (int i = chunk * nFind / nChunks; i < (chunk+1) * nFind / nChunks; i++){
+        
+        const float* q = findDescriptors.ptr<float>(i);
+        
+        for (int j=0; j<nField; j++){
+            
+            // L2 compared squared, same order, sqrt only for the kept matches
+            float dist = bL2 ? normL2Sqr_(q, fieldDescriptors.ptr<float>(j), dims)
+                             : normL1_(q, fieldDescriptors.ptr<float>(j), dims);
+            
+            if (dist < bestFieldDist[i]){
+                bestFieldDist[i] = dist;
+                bestField[i] = j;
+            }
+            if (dist < colBestDist[j]){
+                colBestDist[j] = dist;
+                colBest[j] = i;
+            }
+        }
+    }
+}
+
+
+//--------------------------------------------------------------
+// RESERVE / LOGGING / IMAGES
+//--------------------------------------------------------------
+
+void SIFTMatcher::reserve(int maxKeypoints){
+    
+    // sized for the backend's keypoint cap, so the first frames don't grow them either
+    
+    findKeypoints.reserve(maxKeypoints);
+    fieldKeypoints.reserve(maxKeypoints);
+    matches.reserve(maxKeypoints);
+    goodMatches.reserve(maxKeypoints);
+    findPts.reserve(maxKeypoints);
+    fieldPts.reserve(maxKeypoints);
+    inlierMask.reserve(maxKeypoints);
+    
+    bestField.reserve(maxKeypoints);
+    bestFieldDist.reserve(maxKeypoints);
+    bestFind.reserve(maxKeypoints);
+    bestFindDist.reserve(maxKeypoints);
+    
+    int maxChunks = TaskScheduler::get().getNumThreads() * 2; // crossCheckMatch's most chunks
+    chunkBestFind.reserve(maxChunks * maxKeypoints);
+    chunkBestFindDist.reserve(maxChunks * maxKeypoints);
+}
+
+void SIFTMatcher::setLogging(bool _bLogging){
+    
+    bLogging = _bLogging;
+}
+
+void SIFTMatcher::findImgChanged(){
+    
+    findGeneration++; // next match() converts findImg to grayscale again
+}
+
+const Mat& SIFTMatcher::getFindGray() const{
+    
+    return findGray.get();
+}
+
+const Mat& SIFTMatcher::getFieldGray() const{
+    
+    return fieldGray.get();
+}
+
+
+//--------------------------------------------------------------
+// FEATURE BACKEND
+//--------------------------------------------------------------
+
+void SIFTMatcher::setFeatureBackend(FeatureType type, int maxFeatures){
+    
+    backend = createFeatureBackend(type, maxFeatures);
+    reserve(maxFeatures);
+}
+
+void SIFTMatcher::setFeatureBackend(shared_ptr<FeatureBackend> _backend){
+    
+    backend = _backend;
+}
+
+shared_ptr<FeatureBackend> SIFTMatcher::getFeatureBackend() const{
+    
+    return backend;
+}
+
+
+void SIFTMatcher::setCompressor(shared_ptr<DescriptorCompressor> _compressor){
+    
+    compressor = _compressor;
+}
+
+
+//--------------------------------------------------------------
+// ROI MODE
+//--------------------------------------------------------------
+
+void SIFTMatcher::setRoiMode(bool _bUseRoi, float _roiMargin, int _minRoiMatches){
+    
+    bUseRoi = _bUseRoi;
+    roiMargin = _roiMargin;
+    minRoiMatches = _minRoiMatches;
+}
+
+// sets searchRect to the last fieldCorners' bounding box, grown by roiMargin
+// (or to the whole fieldImg), returns true if it is an ROI
+
+bool SIFTMatcher::updateSearchRect(const Mat& fieldMat){
+    
+    cv::Rect full(0, 0, fieldMat.cols, fieldMat.rows);
+    searchRect = full;
+    
+    if (!bUseRoi || !bRoiValid || fieldCorners.size() < 4) return false;
+    
+    float minX = fieldCorners[0].x, maxX = minX;
+    float minY = fieldCorners[0].y, maxY = minY;
+    
+    for (int i=1; i<4; i++){
+        minX = min(minX, fieldCorners[i].x); maxX = max(maxX, fieldCorners[i].x);
+        minY = min(minY, fieldCorners[i].y); maxY = max(maxY, fieldCorners[i].y);
+    }
+    
+    // grow by margin on every side, relative to the quad's size (motion since the last frame)
+    
+    float margin = roiMargin * max(maxX - minX, maxY - minY);
+    
+    cv::Rect roi(floor(minX - margin), floor(minY - margin),
+                 ceil(maxX - minX + margin * 2), ceil(maxY - minY + margin * 2));
+    roi &= full; // clip to fieldImg
+    
+    if (roi.width < 32 || roi.height < 32) return false; // degenerate / off-screen quad
+    
+    searchRect = roi;
+    
+    return searchRect != full;
+}
+
+ofRectangle SIFTMatcher::getSearchRect() const{
+    
+    return toOf(searchRect);
+}
+
+
+//--------------------------------------------------------------
+// FILTER MATCHES
+// using distance calculations
+//--------------------------------------------------------------
+
+void SIFTMatcher::filterMatches(){
+    
+    bMeshDirty = true;
+    
+    // code referenced from:
+    // http://docs.opencv.org/3.1.0/d5/d6f/tutorial_feature_flann_matcher.html
+    // -----------------------------------------------------------------------
+    
+    uint64_t startTime = ofGetElapsedTimeMillis(); // get start time for speed test
+
+    
+    // loop through matches to find min and max distances
+    
+    double minDist = 100, maxDist = 0;
+    
+    for( int i = 0; i < matches.size(); i++ ) {
+        
+        double dist = matches[i].distance; // calc distance in n-dim space
+        
+        if (dist < minDist) { minDist = dist; }
+        if (dist > maxDist) { maxDist = dist; }
+    }
+    
+
+    // save only "good" matches
+    // here, threshold at 2 * minDist or 0.3 * maxDist, whichever is larger
+    // this is fairly arbitrary
+    
+    goodMatches.clear(); // clear the goodMatches vector (keeps its capacity)
+    
+    double threshold = max(2 * minDist, 0.3 * maxDist);
+    goodMatchThreshold = threshold; // refineHomography's bound for lone candidates
+    
+    for (int i = 0; i < matches.size(); i++) {
+        
+        if (matches[i].distance <= threshold) {
+            
+            goodMatches.push_back(matches[i]); // store as good match
+        }
+    }
+    
+    
+    // print results
+    // --------------
+    uint64_t filterTime = ofGetElapsedTimeMillis() - startTime; // calculate filter time
+    
+    if (bLogging){
+        ofLogNotice("SIFTMatcher") << "took " << filterTime << " ms to filter matches" << endl << endl
+        << "          calc\'ed minDist: " << minDist << ", maxDist: " << maxDist << endl
+        << "          used treshold of: " << threshold << endl
+        << "          saved " << goodMatches.size() << " out of " << matches.size() << " total matches" << endl;
+    }
+    // --------------
+
+    
+}
+
+
+//--------------------------------------------------------------------
+// DRAW MATCHES CV
+// uses cv::drawMatches() to draw matches visualization into _matchImg
+//--------------------------------------------------------------------
+
+void SIFTMatcher::drawMatchesCv(ofImage& _matchImg, bool bUseGoodMatches){
+    
+    //----------------------//
+    //---- DRAW RESULTS ----//
+    //----------------------//
+    
+    /*
+     // cv::drawMatches() displays the images side by side,
+     // with colored circles at each keypoint,
+     // and lines connecting the matched keypoints.
+     // It draws into a Mat.
+     */
+    
+    Mat matchMat; // image-matrix to temp store the results visualization
+    
+    // draw results visualization into matchMat image-matrix
+    
+    // grayscale findImg and fieldImg from the last match()
+    const Mat& findMat = findGray.get();
+    const Mat& fieldMat = fieldGray.get();
+    
+    // pointer to matches vector
+    vector<DMatch>* matchesPtr = &(matches);
+    
+    if (bUseGoodMatches){
+        matchesPtr = &(goodMatches); // or point to goodMatches vector
+    }
+    
+    drawMatches(findMat, findKeypoints, fieldMat, fieldKeypoints, *matchesPtr, matchMat,
+                /* and optional parameters: */
+                Scalar::all(-1), Scalar::all(170), vector<char>(), DrawMatchesFlags::DRAW_RICH_KEYPOINTS);
+    /*
+     // The Scalar::all(-1) through DRAW_RICH_KEYPOINTS parameters are optional.
+     // I'm copying the default arguments for them, except:
+     //      Scalar(170) which draws the unmatched keypoints in gray
+     //      DRAW_RICH_KEYPOINTS, which draws the size/rotation of the keypoints.
+     // The default arguments for those would be:
+     //      Scalar::all(-1) for random colors
+     //      cv::DrawMatchesFlags::DEFAULT for drawing all keypoints as little circles.
+     // see here for drawMatches() reference: http://docs.opencv.org/3.1.0/d4/d5d/group__features2d__draw.html#gsc.tab=0
+     */
+    
+    // convert matchMat to matchImg
+    
+    toOf(matchMat,_matchImg); // wraps matchMat in ofImage matchImg, allocating as needed
+    _matchImg.update(); // updates the matchImg texture on the GPU
+    
+    // now we can draw matchImg in ofApp::draw()
+}
+
+
+//--------------------------------------------------------------------
+// DRAW MATCHES MESH
+// same side by side layout as drawMatchesCv(), drawn straight from
+// findImg's and fieldImg's textures + one batched line mesh of keypoints and matches.
+// the mesh is only rebuilt when the matches change, so redrawing is 3 draw calls
+//--------------------------------------------------------------------
+
+// keypoint as in DRAW_RICH_KEYPOINTS: circle of its size + line showing its orientation
+
+static void addKeypointToMesh(ofMesh& mesh, const KeyPoint& kp, const ofVec2f& offset, const ofFloatColor& color){
+    
+    const int nSegments = 12;
+    static float circle[nSegments + 1][2];
+    static bool bCircleInit = false;
+    
+    if (!bCircleInit){ // unit circle, computed once
+        for (int i=0; i<=nSegments; i++){
+            circle[i][0] = cos(TWO_PI * i / nSegments);
+            circle[i][1] = sin(TWO_PI * i / nSegments);
+        }
+        bCircleInit = true;
+    }
+    
+    ofVec2f center = toOf(kp.pt) + offset;
+    float radius = max(kp.size * 0.5f, 1.f);
+    
+    for (int i=0; i<nSegments; i++){ // one line per segment
+        mesh.addVertex(ofVec3f(center.x + circle[i][0] * radius, center.y + circle[i][1] * radius));
+        mesh.addVertex(ofVec3f(center.x + circle[i+1][0] * radius, center.y + circle[i+1][1] * radius));
+        mesh.addColor(color);
+        mesh.addColor(color);
+    }
+    
+    if (kp.angle >= 0){ // -1 = no orientation
+        float a = ofDegToRad(kp.angle);
+        mesh.addVertex(ofVec3f(center.x, center.y));
+        mesh.addVertex(ofVec3f(center.x + cos(a) * radius, center.y + sin(a) * radius));
+        mesh.addColor(color);
+        mesh.addColor(color);
+    }
+}
+
+
+void SIFTMatcher::buildMatchMesh(bool bUseGoodMatches){
+    
+    const vector<DMatch>& drawn = bUseGoodMatches ? goodMatches : matches;
+    
+    matchMesh.clear(); // keeps the vertex / color vectors' capacity
+    matchMesh.setMode(OF_PRIMITIVE_LINES);
+    
+    ofVec2f findOffset(0, 0);
+    ofVec2f fieldOffset(findGray.get().cols, 0); // fieldImg is drawn to the right of findImg
+    
+    
+    // unmatched keypoints in gray first, so matched ones draw on top
+    
+    findMatched.assign(findKeypoints.size(), 0);
+    fieldMatched.assign(fieldKeypoints.size(), 0);
+    
+    for (int i=0; i<drawn.size(); i++){
+        findMatched[drawn[i].queryIdx] = 1;
+        fieldMatched[drawn[i].trainIdx] = 1;
+    }
+    
+    ofFloatColor gray(170 / 255.f);
+    
+    for (int i=0; i<findKeypoints.size(); i++){
+        if (!findMatched[i]) addKeypointToMesh(matchMesh, findKeypoints[i], findOffset, gray);
+    }
+    for (int i=0; i<fieldKeypoints.size(); i++){
+        if (!fieldMatched[i]) addKeypointToMesh(matchMesh, fieldKeypoints[i], fieldOffset, gray);
+    }
+    
+    
+    // matched pairs: both keypoints + a line between them, one color per match
+    
+    for (int i=0; i<drawn.size(); i++){
+        
+        const KeyPoint& findKp = findKeypoints[drawn[i].queryIdx];
+        const KeyPoint& fieldKp = fieldKeypoints[drawn[i].trainIdx];
+        
+        ofFloatColor color = ofFloatColor::fromHsb(fmod(i * 0.618034f, 1.f), 0.8, 1); // golden ratio steps, neighbors differ
+        
+        addKeypointToMesh(matchMesh, findKp, findOffset, color);
+        addKeypointToMesh(matchMesh, fieldKp, fieldOffset, color);
+        
+        matchMesh.addVertex(ofVec3f(findKp.pt.x + findOffset.x, findKp.pt.y + findOffset.y));
+        matchMesh.addVertex(ofVec3f(fieldKp.pt.x + fieldOffset.x, fieldKp.pt.y + fieldOffset.y));
+        matchMesh.addColor(color);
+        matchMesh.addColor(color);
+    }
+    
+    bMeshDirty = false;
+    bMeshGoodMatches = bUseGoodMatches;
+}
+
+
+void SIFTMatcher::drawMatchesMesh(float x, float y, bool bUseGoodMatches){
+    
+    if (bMeshDirty || bMeshGoodMatches != bUseGoodMatches){
+        buildMatchMesh(bUseGoodMatches); // vbo is re-uploaded on the next draw
+    }
+    
+    ofPushStyle();
+    ofPushMatrix();
+    ofTranslate(x, y);
+    
+        ofSetColor(255);
+        
+        // the images' own textures, nothing re-uploaded
+        // (skipped for images loaded without a texture, or when matching Mats)
+        
+        if (findImg && findImg->isUsingTexture()) findImg->draw(0, 0);
+        if (fieldImg && fieldImg->isUsingTexture()) fieldImg->draw(findGray.get().cols, 0);
+        
+        ofSetLineWidth(1);
+        matchMesh.draw();
+    
+    ofPopMatrix();
+    ofPopStyle();
+}
+
+
+//----------------------------------------------------------------------------------
+// GET HOMOGRAPHY
+// uses cv::findHomography to get transformation values
+// between findImg and fieldImg based on matched keypoints
+// then transforms findImg corners to match where it is in fieldImg
+//----------------------------------------------------------------------------------
+
+bool SIFTMatcher::getHomography(bool bUseGoodMatches){
+    
+    uint64_t startTime = ofGetElapsedTimeMillis(); // save start time (in ms) for testing speed
+    
+    
+    findPts.clear(); // Point2f is cv's ofVec2f
+    fieldPts.clear(); // clear() keeps capacity, so push_back below doesn't reallocate after the first frames
+    
+    // pointer to matches vector
+    vector<DMatch>* matchesPtr = &(matches);
+    
+    if (bUseGoodMatches){
+        matchesPtr = &(goodMatches); // or point to goodMatches vector
+    }
+    
+    for (int i=0; i<matchesPtr->size(); i++){
+        
+        // get original keypoints based on matches
+        
+        int findIndex = (*matchesPtr)[i].queryIdx; // get index in findKeypoints of matched keypoint
+        int fieldIndex = (*matchesPtr)[i].trainIdx; // get index in fieldKeypoints of matched keypoint
+        
+        Point2f& findPt = findKeypoints[findIndex].pt; // get 2D location of findKeypoint
+        Point2f& fieldPt = fieldKeypoints[fieldIndex].pt; // get 2D location of fieldKeypoint
+        
+        // save in vectors
+        findPts.push_back(findPt);
+        fieldPts.push_back(fieldPt);
+        
+    }
+    
+    if (findPts.size() < 4){
+        if (bMatchedRoi) return retryFullImage(bUseGoodMatches);
+        ofLogWarning("SIFTMatcher") << "need at least 4 matches for homography, have " << findPts.size();
+        clearHomography();
+        return false;
+    }
+    
+    // calculate homography matrix using RANSAC method
+    // inlierMask marks which point pairs agree with it
+    
+    Mat H = findHomography(findPts, fieldPts, RANSAC, 3, inlierMask);
+    
+    if (H.empty()){
+        if (bMatchedRoi) return retryFullImage(bUseGoodMatches);
+        ofLogWarning("SIFTMatcher") << "homography failed";
+        clearHomography();
+        return false;
+    }
+    
+    setHomography(H);
+    
+    
+    // print results
+    // --------------
+    uint64_t hTime = ofGetElapsedTimeMillis() - startTime; // calculate homography transform time
+    
+    if (bLogging){
+        ofLogNotice("SIFTMatcher") << "took " << hTime << " ms to do homography transform" << endl << endl
+        << "          x,y corners of findImg in fieldImg" << endl
+        << "          ----------------------------------" << endl
+        << "            " << fieldCorners[0].x << ", " << fieldCorners[0].y << endl
+        << "            " << fieldCorners[1].x << ", " << fieldCorners[1].y << endl
+        << "            " << fieldCorners[2].x << ", " << fieldCorners[2].y << endl
+        << "            " << fieldCorners[3].x << ", " << fieldCorners[3].y << endl
+        << "          " << getNumInliers() << " of " << findPts.size() << " matches are inliers" << endl;
+    }
+    // --------------
+    
+    return true;
+}
+
+
+//----------------------------------------------------------------------------------
+// REFINE HOMOGRAPHY
+// guided matching: with a homography known, each findImg keypoint can only match
+// fieldImg keypoints near where H puts it. searching just that window (through a grid
+// over fieldKeypoints) recovers correct matches the global match + filter threw away,
+// then the homography is fit again on the larger set
+//----------------------------------------------------------------------------------
+
+bool SIFTMatcher::refineHomography(float radius, float ratio, int iterations){
+    
+    if (homography.empty() || findDescriptors.empty() || fieldDescriptors.empty()) return false;
+    
+    uint64_t startTime = ofGetElapsedTimeMillis();
+    
+    const int nFind = findKeypoints.size(), nField = fieldKeypoints.size();
+    const int normType = backend ? backend->getNormType() : NORM_L1;
+    const bool bBinary = (normType == NORM_HAMMING || normType == NORM_HAMMING2);
+    const int nInliersBefore = getNumInliers();
+    
+    
+    // keep the first fit, so a failed refinement leaves it as it was
+    
+    savedMatches = goodMatches;
+    savedFindPts = findPts;
+    savedFieldPts = fieldPts;
+    savedInlierMask = inlierMask;
+    homography.copyTo(savedHomography);
+    
+    
+    // a window with one candidate has no ratio test, so it needs an absolute bound:
+    // filterMatches' threshold, or the worst match the first fit used if it didn't run
+    
+    float loneMaxDist = goodMatchThreshold;
+    if (loneMaxDist <= 0){
+        for (int i=0; i<savedMatches.size(); i++) loneMaxDist = max(loneMaxDist, savedMatches[i].distance);
+    }
+    
+    bool bWasRoi = bMatchedRoi;
+    bMatchedRoi = false; // a failed refit goes back to the first fit, not to a full-image retry
+    
+    const Mat& fieldMat = fieldGray.get();
+    fieldGrid.build(fieldKeypoints, fieldMat.cols, fieldMat.rows, max(8, (int) (radius * 2)));
+    
+    for (int it=0; it<iterations; it++){
+        
+        // project every findImg keypoint into fieldImg
+        
+        findPts.resize(nFind);
+        for (int i=0; i<nFind; i++) findPts[i] = findKeypoints[i].pt;
+        perspectiveTransform(findPts, projectedPts, homography);
+        
+        
+        // best candidate in each window (with ratio test against the window's 2nd best),
+        // and per fieldImg keypoint the findImg keypoint that wants it most (cross check)
+        
+        bestField.assign(nFind, -1);
+        bestFieldDist.assign(nFind, FLT_MAX);
+        bestFind.assign(nField, -1);
+        bestFindDist.assign(nField, FLT_MAX);
+        
+        for (int i=0; i<nFind; i++){
+            
+            const Point2f& p = projectedPts[i];
+            if (p.x < -radius || p.y < -radius || p.x > fieldMat.cols + radius || p.y > fieldMat.rows + radius) continue;
+            
+            fieldGrid.query(p, radius, windowIdx);
+            
+            float best = FLT_MAX, second = FLT_MAX;
+            int bestIdx = -1;
+            
+            for (int k=0; k<windowIdx.size(); k++){
+                
+                int j = windowIdx[k];
+                float dist;
+                
+                if (bBinary){
+                    dist = hammingDistance(findDescriptors.ptr<uchar>(i), fieldDescriptors.ptr<uchar>(j), findDescriptors.cols);
+                } else if (normType == NORM_L2){
+                    dist = sqrtf(normL2Sqr_(findDescriptors.ptr<float>(i), fieldDescriptors.ptr<float>(j), findDescriptors.cols));
+                } else {
+                    dist = normL1_(findDescriptors.ptr<float>(i), fieldDescriptors.ptr<float>(j), findDescriptors.cols);
+                }
+                
+                if (dist < best){
+                    second = best;
+                    best = dist;
+                    bestIdx = j;
+                } else if (dist < second){
+                    second = dist;
+                }
+            }
+            
+            // Lowe's ratio test, or the absolute bound for a lone candidate
+            if (bestIdx < 0) continue;
+            if (second < FLT_MAX ? best >= ratio * second : best > loneMaxDist) continue;
+            
+            bestField[i] = bestIdx;
+            bestFieldDist[i] = best;
+            
+            if (best < bestFindDist[bestIdx]){
+                bestFindDist[bestIdx] = best;
+                bestFind[bestIdx] = i;
+            }
+        }
+        
+        goodMatches.clear();
+        
+        for (int i=0; i<nFind; i++){
+            int j = bestField[i];
+            if (j >= 0 && bestFind[j] == i){
+                goodMatches.push_back(DMatch(i, j, bestFieldDist[i]));
+            }
+        }
+        
+        bMeshDirty = true;
+        
+        
+        // fit again on the guided matches
+        
+        bool bLog = bLogging;
+        bLogging = false; // just one summary below
+        bool bFound = getHomography(true);
+        bLogging = bLog;
+        
+        if (!bFound){
+            
+            // put the first fit back (getHomography also dropped the ROI, it's valid again with it)
+            
+            goodMatches = savedMatches;
+            findPts = savedFindPts;
+            fieldPts = savedFieldPts;
+            inlierMask = savedInlierMask;
+            setHomography(savedHomography);
+            bMatchedRoi = bWasRoi;
+            
+            if (bLogging) ofLogNotice("SIFTMatcher") << "refined homography failed, kept the first fit";
+            
+            return false;
+        }
+    }
+    
+    bMatchedRoi = bWasRoi;
+    
+    if (bLogging){
+        ofLogNotice("SIFTMatcher") << "took " << ofGetElapsedTimeMillis() - startTime << " ms to refine homography" << endl << endl
+        << "          " << goodMatches.size() << " guided matches within " << radius << " px" << endl
+        << "          inliers: " << nInliersBefore << " -> " << getNumInliers()
+        << ", reprojection error " << getReprojectionError() << " px" << endl;
+    }
+    
+    return true;
+}
+
+
+//----------------------------------------------------------------------------------
+// SET HOMOGRAPHY
+// saves H and transforms findImg corners to match where it is in fieldImg
+// (also used by SIFTTracker to set a homography it propagated itself)
+//----------------------------------------------------------------------------------
+
+void SIFTMatcher::setHomography(const Mat& H){
+    
+    H.copyTo(homography);
+    
+    // get the image corners of findImg (size of the last one matched)
+    
+    const Mat& findMat = findGray.get();
+    
+    findMatCorners.resize(4); // members, so this doesn't allocate after the first call
+    fieldMatCorners.resize(4);
+    
+    findMatCorners[0] = cvPoint(0,0);
+    findMatCorners[1] = cvPoint( findMat.cols, 0 );
+    findMatCorners[2] = cvPoint( findMat.cols, findMat.rows );
+    findMatCorners[3] = cvPoint( 0, findMat.rows );
+    
+    // transform findMat corners to correspond with matched keypoints in fieldImg
+    
+    // we'll save the transformed corners in fieldMatCorners
+    
+    perspectiveTransform(findMatCorners, fieldMatCorners, homography); // perform transformation using homography matrix
+    
+    
+    // now convert fieldMatCorners to an ofVec2f vector for use in openFrameworks
+    
+    fieldCorners.clear();
+    for (int i=0; i<4; i++){
+        fieldCorners.push_back(toOf(fieldMatCorners[i]));
+    }
+    
+    bRoiValid = true; // next match() can search around these corners
+}
+
+
+void SIFTMatcher::clearHomography(){
+    
+    // no fit on this frame: nothing from an earlier frame's fit is left to be taken for this one's
+    // (refineHomography, getReprojectionError and drawHomography all check for an empty homography / corners)
+    
+    homography.release();
+    fieldCorners.clear();
+    inlierMask.clear();
+    
+    bRoiValid = false; // search full fieldImg next time
+}
+
+
+float SIFTMatcher::getReprojectionError() const{
+    
+    // RMS distance between inlier fieldPts and their findPts mapped through the homography
+    
+    if (homography.empty() || inlierMask.empty()) return 0;
+    
+    perspectiveTransform(findPts, projectedPts, homography);
+    
+    double total = 0;
+    int n = 0;
+    
+    for (int i=0; i<projectedPts.size(); i++){
+        if (inlierMask[i]){
+            Point2f d = projectedPts[i] - fieldPts[i];
+            total += d.dot(d);
+            n++;
+        }
+    }
+    
+    return n > 0 ? sqrt(total / n) : 0;
+}
+
+
+int SIFTMatcher::getDescriptorBytes() const{
+    
+    return descriptorBytes;
+}
+
+
+int SIFTMatcher::getNumInliers() const{
+    
+    if (inlierMask.empty()) return 0;
+    return countNonZero(inlierMask);
+}
+
+
+//----------------------------------------------------------------------------------
+// DRAW HOMOGRAPHY
+//----------------------------------------------------------------------------------
+
+void SIFTMatcher::drawHomography(float xOffset, float yOffset, ofColor color, float lineWidth){
+    
+    if (fieldCorners.size() < 4) return; // no homography yet
+    
+    ofPushStyle();
+        ofSetColor(color);
+        ofSetLineWidth(lineWidth);
+    
+    ofPushMatrix();
+    ofTranslate(xOffset,yOffset);
+    
+        ofDrawLine(fieldCorners[0],fieldCorners[1]);
+        ofDrawLine(fieldCorners[1],fieldCorners[2]);
+        ofDrawLine(fieldCorners[2],fieldCorners[3]);
+        ofDrawLine(fieldCorners[3],fieldCorners[0]);
+    
+    ofPopMatrix();
+    ofPopStyle();
+    
+}
+
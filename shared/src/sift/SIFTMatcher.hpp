@@ -0,0 +1,186 @@
+//
+//  SIFTMatcher.hpp
+//  SIFT_filterMatches_homography
+//
+//  Created by Tyler on 3/24/16.
+//
+//
+
+#pragma once 
+#include "ofMain.h"
+#include "ofxOpenCv.h"
+#include "ofxCv.h"
+
+#include "FeatureBackend.hpp"
+#include "HammingIndex.hpp"
+#include "DescriptorCompressor.hpp"
+#include "ReservedMat.hpp"
+#include "GrayscaleCache.hpp"
+#include "KeypointGrid.hpp"
+#include "TaskScheduler.hpp"
+
+using namespace cv;
+using namespace ofxCv;
+
+class SIFTMatcher {
+    
+public:
+    
+    SIFTMatcher();
+    
+    SIFTMatcher(ofImage& _findImg, ofImage& _fieldImg);
+    
+    void match();
+    // returns vector of keypoint matches between "query" image (_findImg) and "train" image (_fieldImg)
+    // works on grayscale copies owned by the matcher, doesn't change either image
+    
+    void match(const Mat& findMat, const Mat& fieldMat);
+    // same on Mats, for headless / batch use without ofImages (only the draw functions need those).
+    // grayscale, RGB or RGBA (oF channel order); fieldMat is taken to be new on every call,
+    // findMat is converted again after findImgChanged() or when its data moves
+    
+    void findImgChanged();
+    // call after changing findImg's pixels in place, so the next match() picks them up
+    // (fieldImg is taken to be new on every match())
+    
+    const Mat& getFindGray() const;
+    const Mat& getFieldGray() const;
+    // grayscale images used by the last match()
+    
+    void matchDescriptors();
+    // just the matching step of match(): findDescriptors vs fieldDescriptors -> matches
+    
+    void reserve(int maxKeypoints);
+    // pre-sizes the keypoint / match / point buffers (done by setFeatureBackend)
+    // all buffers and algorithm objects live between calls, so once warmed up
+    // matchDescriptors(), filterMatches() and the point handling in getHomography() don't allocate
+    
+    void setLogging(bool _bLogging);
+    // timing + stats to the console (on by default), building the log messages allocates
+    
+    void setFeatureBackend(FeatureType type, int maxFeatures = 2000);
+    void setFeatureBackend(shared_ptr<FeatureBackend> _backend);
+    shared_ptr<FeatureBackend> getFeatureBackend() const;
+    // keypoint detector + descriptor used by match(), SIFT if not set
+    // binary backends (ORB, BRISK) are matched through an LSH index with popcount Hamming distance
+    
+    void setCompressor(shared_ptr<DescriptorCompressor> _compressor);
+    // optional: match SIFT descriptors through RootSIFT + PCA + product quantization codes
+    // (trained on the first fieldImg if not trained yet), pass an empty pointer to turn off
+    
+    void setRoiMode(bool _bUseRoi, float _roiMargin = 0.25, int _minRoiMatches = 10);
+    // ROI mode: after a homography was found, match() only searches fieldImg
+    // around the last fieldCorners, grown by roiMargin * the quad's size on each side.
+    // falls back to the full fieldImg if the ROI gives fewer than minRoiMatches matches
+    // or the last homography failed
+    
+    ofRectangle getSearchRect() const;
+    // area of fieldImg searched by the last match()
+    
+    void filterMatches();
+    // filters outliers in matches vector based on distance
+    
+    void drawMatchesCv(ofImage& _matchImg, bool bUseGoodMatches = false);
+    // draws match visualization into _matchImg
+    // bUseGoodMatches draws matches vector if false or goodMatches vector if true
+    
+    void drawMatchesMesh(float x = 0, float y = 0, bool bUseGoodMatches = false);
+    // draws the same visualization directly: findImg + fieldImg side by side from their textures,
+    // keypoints and match lines from one ofVboMesh, rebuilt only when the matches change
+    
+    bool getHomography(bool bUseGoodMatches = false);
+    // calculates homography between matched keypoints
+    // and transforms corners of findImg to match coordinates in fieldImg
+    // returns false if there weren't enough matches, the homography + corners are then empty
+    
+    bool refineHomography(float radius = 8, float ratio = 0.8, int iterations = 2);
+    // guided matching after getHomography(): each findImg keypoint is matched only against
+    // fieldImg keypoints within radius px of where the homography puts it (grid lookup),
+    // with ratio test + cross check (a lone candidate in a window has to be within filterMatches' threshold).
+    // the result replaces goodMatches and the homography is fit again, repeated for iterations rounds.
+    // returns false if there's no homography or the new fit failed, goodMatches + homography are then
+    // left as getHomography() had them
+    
+    void setHomography(const Mat& H);
+    // sets homography directly + transforms corners of findImg
+    
+    int getNumInliers() const;
+    // # of matches that agreed with the last homography
+    
+    float getReprojectionError() const;
+    // RMS error (px) of the inliers under the last homography
+    
+    int getDescriptorBytes() const;
+    // bytes per descriptor from the last match() (SIFT 512, ORB 32, BRISK 64)
+    
+    void drawHomography(float xOffset = 0, float yOffset = 0, ofColor color = ofColor::cyan, float lineWidth = 3);
+    // draws warped box in fieldImg coordinates of where findImg was found
+    // x and yOffset draw
+    
+    ofImage* findImg = nullptr;
+    ofImage* fieldImg = nullptr;
+    
+    vector<KeyPoint> findKeypoints, fieldKeypoints;
+    Mat findDescriptors, fieldDescriptors; // row i describes keypoint i
+    Mat fieldCodes; // compressed fieldDescriptors, if a compressor is set
+    vector<DMatch> matches;
+    vector<DMatch> goodMatches;
+    
+    vector<Point2f> findPts, fieldPts; // matched keypoint locations used for the last homography
+    vector<uchar> inlierMask; // 1 for each findPts/fieldPts pair that is a RANSAC inlier
+    Mat homography; // findImg -> fieldImg
+    
+    vector<ofVec2f> fieldCorners; // stores corners of findImg transformed into fieldImg space
+    
+private:
+    
+    bool updateSearchRect(const Mat& fieldMat);
+    bool retryFullImage(bool bUseGoodMatches); // getHomography() after a failed ROI search
+    void clearHomography(); // after a failed fit: homography, fieldCorners and inlierMask emptied
+    void crossCheckMatch(int normType);
+    void crossCheckChunk(int chunk, int nChunks, bool bL2); // rows of one crossCheckMatch task
+    void buildMatchMesh(bool bUseGoodMatches);
+    
+    shared_ptr<FeatureBackend> backend;
+    HammingIndex hammingIndex;
+    shared_ptr<DescriptorCompressor> compressor;
+    ReservedMat codesBuf; // fieldCodes' storage
+    
+    GrayscaleCache findGray, fieldGray;
+    uint64_t findGeneration = 0, fieldGeneration = 0;
+    bool bRoiRetry = false;
+    bool bMatchedRoi = false; // the last match() searched an ROI (not all of fieldImg)
+    
+    // drawMatchesMesh
+    ofVboMesh matchMesh;
+    bool bMeshDirty = true, bMeshGoodMatches = false;
+    vector<char> findMatched, fieldMatched; // per keypoint, part of a drawn match
+    int descriptorBytes = 0;
+    bool bLogging = true;
+    
+    // refineHomography
+    KeypointGrid fieldGrid;
+    vector<int> windowIdx;
+    vector<DMatch> savedMatches; // the fit before refining, put back if refining fails
+    vector<Point2f> savedFindPts, savedFieldPts;
+    vector<uchar> savedInlierMask;
+    Mat savedHomography;
+    float goodMatchThreshold = 0; // filterMatches' last distance threshold, 0 if it hasn't run
+    
+    // crossCheckMatch / refineHomography scratch: nearest fieldImg descriptor per findImg descriptor and vice versa
+    vector<int> bestField, bestFind;
+    vector<float> bestFieldDist, bestFindDist;
+    vector<int> chunkBestFind; // crossCheckMatch: per column bests of each chunk of rows
+    vector<float> chunkBestFindDist;
+    
+    // setHomography / getReprojectionError scratch
+    vector<Point2f> findMatCorners, fieldMatCorners;
+    mutable vector<Point2f> projectedPts;
+    
+    bool bUseRoi = false, bRoiValid = false;
+    float roiMargin = 0.25;
+    int minRoiMatches = 10;
+    cv::Rect searchRect;
+    
+    
+};
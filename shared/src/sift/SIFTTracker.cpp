@@ -0,0 +1,216 @@
+//
+//  SIFTTracker.cpp
+//  SIFT_filterMatches_homography
+//
+
+#include "SIFTTracker.hpp"
+
+
+//--------------------------------------------------------------
+// Constructor
+//--------------------------------------------------------------
+
+SIFTTracker::SIFTTracker(){
+}
+
+void SIFTTracker::setup(ofImage& _findImg, int _minInliers){
+
+    findImg = &_findImg;
+    minInliers = max(4, _minInliers); // homography needs at least 4
+
+    frameImg.setUseTexture(false); // only used as matcher input, never drawn
+
+    matcher = SIFTMatcher(*findImg, frameImg);
+    matcher.setRoiMode(true); // keyframes after losing track search around the last position first
+
+    bFound = false;
+}
+
+
+//--------------------------------------------------------------
+// UPDATE
+// cheap propagation if we're tracking, full SIFT match if we lost it
+//--------------------------------------------------------------
+
+bool SIFTTracker::update(ofPixels& frame){
+
+    uint64_t startTime = ofGetElapsedTimeMillis();
+
+    bKeyframe = false;
+
+    if (bFound){
+        bFound = propagate(frame);
+    }
+
+    if (!bFound){
+        bKeyframe = true;
+        bFound = detect(frame);
+    }
+
+    if (!bFound){
+        matcher.fieldCorners.clear(); // they're from an earlier frame, don't draw / return them as this one's
+    }
+
+    ofLogVerbose("SIFTTracker") << (bKeyframe ? "keyframe" : "tracked") << " in " << ofGetElapsedTimeMillis() - startTime << " ms, "
+    << trackPts.size() << " points";
+
+    return bFound;
+}
+
+
+//--------------------------------------------------------------
+// DETECT
+// full SIFT match on this frame, keeps the homography's inliers as points to track
+//--------------------------------------------------------------
+
+bool SIFTTracker::detect(ofPixels& frame){
+
+    frameImg.setFromPixels(frame);
+
+    matcher.match();
+    matcher.filterMatches();
+
+    if (!matcher.getHomography(true)){
+        trackPts.clear();
+        return false;
+    }
+
+    // guided matching adds the matches the first fit missed, so more inliers to track
+    // (if it fails, the matcher keeps the first fit and that's tracked instead)
+
+    matcher.refineHomography();
+
+    if (matcher.getNumInliers() < minInliers){
+        trackPts.clear();
+        return false;
+    }
+
+    findPts.clear();
+    trackPts.clear();
+
+    for (int i=0; i<matcher.inlierMask.size(); i++){
+        if (matcher.inlierMask[i]){
+            findPts.push_back(matcher.findPts[i]);
+            trackPts.push_back(matcher.fieldPts[i]);
+        }
+    }
+
+    matcher.getFieldGray().copyTo(prevGray); // the grayscale frame match() worked on
+
+    return true;
+}
+
+
+//--------------------------------------------------------------
+// PROPAGATE
+// follow last frame's points with pyramidal Lucas-Kanade,
+// then re-fit the homography from findImg to where they moved.
+// only ~tens to hundreds of points, so this is a small fraction of a SIFT match
+//--------------------------------------------------------------
+
+bool SIFTTracker::propagate(ofPixels& frame){
+
+    Mat frameMat = toCv(frame);
+
+    if (frameMat.channels() == 3){
+        cvtColor(frameMat, currGray, CV_RGB2GRAY);
+    } else if (frameMat.channels() == 4){
+        cvtColor(frameMat, currGray, CV_RGBA2GRAY);
+    } else {
+        frameMat.copyTo(currGray);
+    }
+
+    if (currGray.size() != prevGray.size()) return false; // video size changed, start over
+
+    calcOpticalFlowPyrLK(prevGray, currGray, trackPts, nextPts, status, err, cv::Size(21,21), 3);
+
+
+    // keep the points LK could follow
+
+    keptFindPts.clear();
+    keptNextPts.clear();
+
+    for (int i=0; i<status.size(); i++){
+        if (status[i]){
+            keptFindPts.push_back(findPts[i]);
+            keptNextPts.push_back(nextPts[i]);
+        }
+    }
+
+    if (keptFindPts.size() < minInliers) return false;
+
+
+    // re-fit the homography, drop points that drifted off it
+
+    Mat H = findHomography(keptFindPts, keptNextPts, RANSAC, 3, inlierMask);
+    if (H.empty()) return false;
+
+    findPts.clear();
+    trackPts.clear();
+
+    for (int i=0; i<inlierMask.size(); i++){
+        if (inlierMask[i]){
+            findPts.push_back(keptFindPts[i]);
+            trackPts.push_back(keptNextPts[i]);
+        }
+    }
+
+    if (trackPts.size() < minInliers) return false;
+
+    matcher.setHomography(H);
+
+    swap(prevGray, currGray); // this frame is next frame's previous
+
+    return true;
+}
+
+
+//--------------------------------------------------------------
+// GETTERS
+//--------------------------------------------------------------
+
+bool SIFTTracker::isFound() const{
+    return bFound;
+}
+
+bool SIFTTracker::isKeyframe() const{
+    return bKeyframe;
+}
+
+int SIFTTracker::getNumTracked() const{
+    return trackPts.size();
+}
+
+const vector<ofVec2f>& SIFTTracker::getCorners() const{
+    return matcher.fieldCorners;
+}
+
+const Mat& SIFTTracker::getHomography() const{
+    return matcher.homography;
+}
+
+
+//--------------------------------------------------------------
+// DRAW
+//--------------------------------------------------------------
+
+void SIFTTracker::draw(float xOffset, float yOffset, ofColor color, float lineWidth){
+
+    if (!bFound) return;
+
+    ofPushStyle();
+    ofPushMatrix();
+    ofTranslate(xOffset, yOffset);
+
+        ofSetColor(color, 150);
+        ofFill();
+
+        for (int i=0; i<trackPts.size(); i++){
+            ofDrawCircle(toOf(trackPts[i]), 2);
+        }
+
+    ofPopMatrix();
+    ofPopStyle();
+
+    matcher.drawHomography(xOffset, yOffset, color, lineWidth);
+}
@@ -0,0 +1,63 @@
+//
+//  SIFTTracker.hpp
+//  SIFT_filterMatches_homography
+//
+
+#pragma once
+#include "ofMain.h"
+#include "SIFTMatcher.hpp"
+
+using namespace cv;
+using namespace ofxCv;
+
+
+// locates findImg in every frame of a video
+// full SIFT match + homography only on keyframes,
+// in between the keyframe's inlier points are followed with sparse (Lucas-Kanade) flow
+// and the homography is re-fit to where they moved.
+// re-detects when too few tracked points still agree with the homography
+
+class SIFTTracker {
+
+public:
+
+    SIFTTracker();
+    SIFTTracker(const SIFTTracker&) = delete; // matcher points at this tracker's own frameImg,
+    SIFTTracker& operator=(const SIFTTracker&) = delete; // a copy's would point into the original
+
+    void setup(ofImage& _findImg, int _minInliers = 12);
+    // minInliers = re-detect with SIFT when fewer tracked points than this are left
+
+    bool update(ofPixels& frame);
+    // returns true if findImg was located in this frame
+
+    bool isFound() const;
+    bool isKeyframe() const; // true if this frame ran a full SIFT match
+    int getNumTracked() const; // # of points currently followed
+    const vector<ofVec2f>& getCorners() const; // corners of findImg in frame coords, empty if it wasn't found in this frame
+    const Mat& getHomography() const;
+
+    void draw(float xOffset = 0, float yOffset = 0, ofColor color = ofColor::cyan, float lineWidth = 3);
+    // draws the tracked points and the box around findImg
+
+    SIFTMatcher matcher; // used for keyframes
+
+private:
+
+    bool detect(ofPixels& frame);
+    bool propagate(ofPixels& frame);
+
+    ofImage* findImg = nullptr;
+    ofImage frameImg; // keyframe copy handed to matcher (no texture)
+
+    int minInliers = 12;
+    bool bFound = false, bKeyframe = false;
+
+    // reused every frame
+    Mat prevGray, currGray;
+    vector<Point2f> findPts, trackPts; // tracked point pairs: location in findImg, location in last frame
+    vector<Point2f> nextPts, keptFindPts, keptNextPts;
+    vector<uchar> status, inlierMask;
+    vector<float> err;
+
+};